@@ -6,6 +6,7 @@
 #include "city/buildings.h"
 #include "city/population.h"
 #include "city/warning.h"
+#include "core/calc.h"
 #include "figure/formation_legion.h"
 #include "game/resource.h"
 #include "game/undo.h"
@@ -30,6 +31,132 @@ static struct {
     int unfixable_houses;
 } extra = {0, 0, 0, 0};
 
+#define INDEX_WORD_BITS 32
+#define INDEX_WORDS ((MAX_BUILDINGS + INDEX_WORD_BITS - 1) / INDEX_WORD_BITS)
+
+// Which building ids have which type, so code interested in one type does not need to check every building
+static struct {
+    uint32_t types[BUILDING_TYPE_MAX][INDEX_WORDS];
+    uint32_t houses[INDEX_WORDS];
+    short indexed_type[MAX_BUILDINGS];
+    int version;
+} type_index;
+
+// Ids known to be in use, so building_create() can skip them. An id taken outside building_create()
+// is only marked when building_create() comes across it.
+static uint32_t used_ids[INDEX_WORDS];
+
+static int is_valid_type(int type)
+{
+    return type > BUILDING_NONE && type < BUILDING_TYPE_MAX;
+}
+
+static void set_index_bit(uint32_t *bits, int id, int value)
+{
+    if (value) {
+        bits[id / INDEX_WORD_BITS] |= 1u << (id % INDEX_WORD_BITS);
+    } else {
+        bits[id / INDEX_WORD_BITS] &= ~(1u << (id % INDEX_WORD_BITS));
+    }
+}
+
+static int next_id_in_index(const uint32_t *bits, int id)
+{
+    int next = id + 1;
+    if (next <= 0 || next >= MAX_BUILDINGS) {
+        return 0;
+    }
+    int word_index = next / INDEX_WORD_BITS;
+    uint32_t word = bits[word_index] & (~0u << (next % INDEX_WORD_BITS));
+    while (!word) {
+        if (++word_index >= INDEX_WORDS) {
+            return 0;
+        }
+        word = bits[word_index];
+    }
+    return word_index * INDEX_WORD_BITS + calc_lowest_set_bit(word);
+}
+
+static int next_unused_id(int id)
+{
+    int next = id + 1;
+    if (next <= 0 || next >= MAX_BUILDINGS) {
+        return 0;
+    }
+    int word_index = next / INDEX_WORD_BITS;
+    uint32_t word = ~used_ids[word_index] & (~0u << (next % INDEX_WORD_BITS));
+    while (!word) {
+        if (++word_index >= INDEX_WORDS) {
+            return 0;
+        }
+        word = ~used_ids[word_index];
+    }
+    next = word_index * INDEX_WORD_BITS + calc_lowest_set_bit(word);
+    return next < MAX_BUILDINGS ? next : 0;
+}
+
+void building_update_type_index(building *b)
+{
+    int id = b->id;
+    if (id <= 0 || id >= MAX_BUILDINGS || type_index.indexed_type[id] == b->type) {
+        return;
+    }
+    int old_type = type_index.indexed_type[id];
+    if (is_valid_type(old_type)) {
+        set_index_bit(type_index.types[old_type], id, 0);
+        set_index_bit(type_index.houses, id, 0);
+    }
+    if (is_valid_type(b->type)) {
+        set_index_bit(type_index.types[b->type], id, 1);
+        set_index_bit(type_index.houses, id, building_is_house(b->type));
+    }
+    type_index.indexed_type[id] = b->type;
+    type_index.version++;
+}
+
+static void rebuild_used_ids(void)
+{
+    memset(used_ids, 0, sizeof(used_ids));
+    for (int i = 1; i < MAX_BUILDINGS; i++) {
+        set_index_bit(used_ids, i, all_buildings[i].state != BUILDING_STATE_UNUSED);
+    }
+}
+
+static void rebuild_type_index(void)
+{
+    int version = type_index.version;
+    memset(&type_index, 0, sizeof(type_index));
+    type_index.version = version + 1;
+    for (int i = 1; i < MAX_BUILDINGS; i++) {
+        building_update_type_index(&all_buildings[i]);
+    }
+}
+
+int building_type_index_version(void)
+{
+    return type_index.version;
+}
+
+int building_first_of_type(building_type type)
+{
+    return building_next_of_type(type, 0);
+}
+
+int building_next_of_type(building_type type, int id)
+{
+    return is_valid_type(type) ? next_id_in_index(type_index.types[type], id) : 0;
+}
+
+int building_first_house(void)
+{
+    return building_next_house(0);
+}
+
+int building_next_house(int id)
+{
+    return next_id_in_index(type_index.houses, id);
+}
+
 building *building_get(int id)
 {
     return &all_buildings[id];
@@ -54,9 +181,12 @@ building *building_next(building *b)
 building *building_create(building_type type, int x, int y)
 {
     building *b = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        if (all_buildings[i].state == BUILDING_STATE_UNUSED && !game_undo_contains_building(i)) {
+    for (int i = next_unused_id(0); i; i = next_unused_id(i)) {
+        if (all_buildings[i].state != BUILDING_STATE_UNUSED) {
+            set_index_bit(used_ids, i, 1);
+        } else if (!game_undo_contains_building(i)) {
             b = &all_buildings[i];
+            set_index_bit(used_ids, i, 1);
             break;
         }
     }
@@ -166,6 +296,7 @@ building *building_create(building_type type, int x, int y)
     b->fire_proof = props->fire_proof;
     b->is_adjacent_to_water = map_terrain_is_adjacent_to_water(x, y, b->size);
 
+    building_update_type_index(b);
     return b;
 }
 
@@ -175,6 +306,8 @@ static void building_delete(building *b)
     int id = b->id;
     memset(b, 0, sizeof(building));
     b->id = id;
+    building_update_type_index(b);
+    set_index_bit(used_ids, id, 0);
 }
 
 void building_clear_related_data(building *b)
@@ -322,6 +455,8 @@ void building_clear_all(void)
     extra.created_sequence = 0;
     extra.incorrect_houses = 0;
     extra.unfixable_houses = 0;
+    rebuild_type_index();
+    rebuild_used_ids();
 }
 
 void building_save_state(buffer *buf, buffer *highest_id, buffer *highest_id_ever,
@@ -353,4 +488,6 @@ void building_load_state(buffer *buf, buffer *highest_id, buffer *highest_id_eve
 
     extra.incorrect_houses = buffer_read_i32(corrupt_houses);
     extra.unfixable_houses = buffer_read_i32(corrupt_houses);
+    rebuild_type_index();
+    rebuild_used_ids();
 }
@@ -155,6 +155,36 @@ void building_update_desirability(void);
 
 int building_is_house(building_type type);
 
+/**
+ * Updates the type index after the type of a building was changed directly
+ * @param b Building
+ */
+void building_update_type_index(building *b);
+
+/**
+ * Gets a number that changes whenever a building is added to or removed from the type index
+ * @return Type index version
+ */
+int building_type_index_version(void);
+
+/**
+ * Iterates over the buildings of a type, whatever their state, in ascending id order:
+ * for (int id = building_first_of_type(type); id; id = building_next_of_type(type, id))
+ * @param type Building type
+ * @return Building id, or 0 if there are no more
+ */
+int building_first_of_type(building_type type);
+
+int building_next_of_type(building_type type, int id);
+
+/**
+ * Iterates over the buildings of any house type, like building_first_of_type()
+ * @return Building id, or 0 if there are no more
+ */
+int building_first_house(void);
+
+int building_next_house(int id);
+
 int building_is_fort(building_type type);
 
 int building_get_highest_id(void);
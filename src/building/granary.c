@@ -3,6 +3,7 @@
 #include "building/destruction.h"
 #include "building/model.h"
 #include "building/storage.h"
+#include "building/storage_index.h"
 #include "building/warehouse.h"
 #include "city/message.h"
 #include "city/resource.h"
@@ -177,9 +178,9 @@ void building_granaries_calculate_stocks(void)
     non_getting_granaries.total_storage_fruit = 0;
     non_getting_granaries.total_storage_meat = 0;
 
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_GRANARY); i; i = building_next_of_type(BUILDING_GRANARY, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         if (!b->has_road_access || b->distance_from_entry <= 0) {
@@ -212,6 +213,68 @@ void building_granaries_calculate_stocks(void)
     }
 }
 
+typedef struct {
+    int x;
+    int y;
+    int resource;
+    int distance_from_entry;
+    int road_network_id;
+    int *understaffed;
+} storing_query;
+
+static int get_distance_for_storing(building *b, void *data)
+{
+    const storing_query *query = data;
+    if (b->state != BUILDING_STATE_IN_USE) {
+        return INFINITE;
+    }
+    if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != query->road_network_id) {
+        return INFINITE;
+    }
+    int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
+    if (pct_workers < 100) {
+        if (query->understaffed) {
+            *query->understaffed += 1;
+        }
+        return INFINITE;
+    }
+    const building_storage *s = building_storage_get(b->storage_id);
+    if (s->resource_state[query->resource] == BUILDING_STORAGE_STATE_NOT_ACCEPTING || s->empty_all) {
+        return INFINITE;
+    }
+    if (b->data.granary.resource_stored[RESOURCE_NONE] >= ONE_LOAD) {
+        // there is room
+        return calc_distance_with_penalty(
+            b->x + 1, b->y + 1, query->x, query->y, query->distance_from_entry, b->distance_from_entry);
+    }
+    return INFINITE;
+}
+
+static int get_distance_for_storing_in_getting(building *b, void *data)
+{
+    const storing_query *query = data;
+    if (b->state != BUILDING_STATE_IN_USE) {
+        return INFINITE;
+    }
+    if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != query->road_network_id) {
+        return INFINITE;
+    }
+    int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
+    if (pct_workers < 100) {
+        return INFINITE;
+    }
+    const building_storage *s = building_storage_get(b->storage_id);
+    if (s->resource_state[query->resource] != BUILDING_STORAGE_STATE_GETTING || s->empty_all) {
+        return INFINITE;
+    }
+    if (b->data.granary.resource_stored[RESOURCE_NONE] > ONE_LOAD) {
+        // there is room
+        return calc_distance_with_penalty(
+            b->x + 1, b->y + 1, query->x, query->y, query->distance_from_entry, b->distance_from_entry);
+    }
+    return INFINITE;
+}
+
 int building_granary_for_storing(int x, int y, int resource, int distance_from_entry, int road_network_id,
                                  int force_on_stockpile, int *understaffed, map_point *dst)
 {
@@ -224,37 +287,10 @@ int building_granary_for_storing(int x, int y, int resource, int distance_from_e
     if (city_resource_is_stockpiled(resource) && !force_on_stockpile) {
         return 0;
     }
-    int min_dist = INFINITE;
-    int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
-            continue;
-        }
-        if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != road_network_id) {
-            continue;
-        }
-        int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
-        if (pct_workers < 100) {
-            if (understaffed) {
-                *understaffed += 1;
-            }
-            continue;
-        }
-        const building_storage *s = building_storage_get(b->storage_id);
-        if (s->resource_state[resource] == BUILDING_STORAGE_STATE_NOT_ACCEPTING || s->empty_all) {
-            continue;
-        }
-        if (b->data.granary.resource_stored[RESOURCE_NONE] >= ONE_LOAD) {
-            // there is room
-            int dist = calc_distance_with_penalty(
-                b->x + 1, b->y + 1, x, y, distance_from_entry, b->distance_from_entry);
-            if (dist < min_dist) {
-                min_dist = dist;
-                min_building_id = i;
-            }
-        }
-    }
+    storing_query query = {x, y, resource, distance_from_entry, road_network_id, understaffed};
+    // distances are to the center of the granary, one tile away from the tile it is indexed by
+    int min_building_id = building_storage_index_find_nearest(BUILDING_GRANARY, x, y, 1, INFINITE,
+        get_distance_for_storing, &query);
     // deliver to center of granary
     building *min = building_get(min_building_id);
     map_point_store_result(min->x + 1, min->y + 1, dst);
@@ -273,34 +309,9 @@ int building_getting_granary_for_storing(int x, int y, int resource, int distanc
     if (city_resource_is_stockpiled(resource)) {
         return 0;
     }
-    int min_dist = INFINITE;
-    int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
-            continue;
-        }
-        if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != road_network_id) {
-            continue;
-        }
-        int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
-        if (pct_workers < 100) {
-            continue;
-        }
-        const building_storage *s = building_storage_get(b->storage_id);
-        if (s->resource_state[resource] != BUILDING_STORAGE_STATE_GETTING || s->empty_all) {
-            continue;
-        }
-        if (b->data.granary.resource_stored[RESOURCE_NONE] > ONE_LOAD) {
-            // there is room
-            int dist = calc_distance_with_penalty(
-                b->x + 1, b->y + 1, x, y, distance_from_entry, b->distance_from_entry);
-            if (dist < min_dist) {
-                min_dist = dist;
-                min_building_id = i;
-            }
-        }
-    }
+    storing_query query = {x, y, resource, distance_from_entry, road_network_id, 0};
+    int min_building_id = building_storage_index_find_nearest(BUILDING_GRANARY, x, y, 1, INFINITE,
+        get_distance_for_storing_in_getting, &query);
     building *min = building_get(min_building_id);
     map_point_store_result(min->x + 1, min->y + 1, dst);
     return min_building_id;
@@ -374,9 +385,9 @@ void building_granary_bless(void)
 {
     int min_stored = INFINITE;
     building *min_building = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_GRANARY); i; i = building_next_of_type(BUILDING_GRANARY, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         int total_stored = 0;
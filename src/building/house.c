@@ -53,6 +53,7 @@ static struct {
 void building_house_change_to(building *house, building_type type)
 {
     house->type = type;
+    building_update_type_index(house);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     int image_id = image_group(HOUSE_IMAGE[house->subtype.house_level].group);
     if (house->house_is_merged) {
@@ -78,6 +79,7 @@ static void create_vacant_lot(int x, int y, int image_id)
 void building_house_change_to_vacant_lot(building *house)
 {
     house->type = BUILDING_HOUSE_VACANT_LOT;
+    building_update_type_index(house);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     int image_id = image_group(GROUP_BUILDING_HOUSE_VACANT_LOT);
     if (house->house_is_merged) {
@@ -282,6 +284,7 @@ static void split_size2(building *house, building_type new_type)
 
     // main tile
     house->type = new_type;
+    building_update_type_index(house);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     house->size = house->house_size = 1;
     house->house_is_merged = 0;
@@ -316,6 +319,7 @@ static void split_size3(building *house)
 
     // main tile
     house->type = BUILDING_HOUSE_MEDIUM_INSULA;
+    building_update_type_index(house);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     house->size = house->house_size = 1;
     house->house_is_merged = 0;
@@ -366,6 +370,7 @@ void building_house_expand_to_large_insula(building *house)
     prepare_for_merge(house->id, 4);
 
     house->type = BUILDING_HOUSE_LARGE_INSULA;
+    building_update_type_index(house);
     house->subtype.house_level = HOUSE_LARGE_INSULA;
     house->size = house->house_size = 2;
     house->house_population += merge_data.population;
@@ -386,6 +391,7 @@ void building_house_expand_to_large_villa(building *house)
     prepare_for_merge(house->id, 9);
 
     house->type = BUILDING_HOUSE_LARGE_VILLA;
+    building_update_type_index(house);
     house->subtype.house_level = HOUSE_LARGE_VILLA;
     house->size = house->house_size = 3;
     house->house_population += merge_data.population;
@@ -406,6 +412,7 @@ void building_house_expand_to_large_palace(building *house)
     prepare_for_merge(house->id, 16);
 
     house->type = BUILDING_HOUSE_LARGE_PALACE;
+    building_update_type_index(house);
     house->subtype.house_level = HOUSE_LARGE_PALACE;
     house->size = house->house_size = 4;
     house->house_population += merge_data.population;
@@ -440,6 +447,7 @@ void building_house_devolve_from_large_villa(building *house)
 
     // main tile
     house->type = BUILDING_HOUSE_MEDIUM_VILLA;
+    building_update_type_index(house);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     house->size = house->house_size = 2;
     house->house_is_merged = 0;
@@ -482,6 +490,7 @@ void building_house_devolve_from_large_palace(building *house)
 
     // main tile
     house->type = BUILDING_HOUSE_MEDIUM_PALACE;
+    building_update_type_index(house);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     house->size = house->house_size = 3;
     house->house_is_merged = 0;
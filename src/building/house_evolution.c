@@ -508,9 +508,9 @@ void building_house_process_evolve_and_consume_goods(void)
     city_houses_reset_demands();
     house_demands *demands = city_houses_demands();
     int has_expanded = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && building_is_house(b->type)) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             building_house_check_for_corruption(b);
             has_expanded |= evolve_callback[b->type - BUILDING_HOUSE_VACANT_LOT](b, demands);
             if (game_time_day() == 0 || game_time_day() == 7) {
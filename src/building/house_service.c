@@ -14,7 +14,7 @@ static void decay(unsigned char *value)
 
 void house_service_decay_culture(void)
 {
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || !b->house_size) {
             continue;
@@ -67,7 +67,7 @@ void house_service_decay_houses_covered(void)
 void house_service_calculate_culture_aggregates(void)
 {
     int base_entertainment = city_culture_coverage_average_entertainment() / 5;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || !b->house_size) {
             continue;
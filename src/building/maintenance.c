@@ -39,9 +39,10 @@ void building_maintenance_update_burning_ruins(void)
     scenario_climate climate = scenario_property_climate();
     int recalculate_terrain = 0;
     building_list_burning_clear();
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_BURNING_RUIN); i;
+         i = building_next_of_type(BUILDING_BURNING_RUIN, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_BURNING_RUIN) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         if (b->fire_duration < 0) {
@@ -0,0 +1,137 @@
+#include "storage_index.h"
+
+#include "core/calc.h"
+#include "map/grid.h"
+
+#define CELL_SIZE 8
+#define CELLS ((GRID_SIZE + CELL_SIZE - 1) / CELL_SIZE)
+
+enum {
+    INDEX_WAREHOUSE = 0,
+    INDEX_WAREHOUSE_SPACE = 1,
+    INDEX_GRANARY = 2,
+    INDEX_MAX = 3
+};
+
+typedef struct {
+    // ids in cell order, in id order within a cell
+    short ids[MAX_BUILDINGS];
+    short cell_start[CELLS * CELLS + 1];
+} storage_index;
+
+static struct {
+    storage_index index[INDEX_MAX];
+    int type_index_version;
+    int is_valid;
+} data;
+
+static int get_index(building_type type)
+{
+    switch (type) {
+        case BUILDING_WAREHOUSE: return INDEX_WAREHOUSE;
+        case BUILDING_WAREHOUSE_SPACE: return INDEX_WAREHOUSE_SPACE;
+        case BUILDING_GRANARY: return INDEX_GRANARY;
+        default: return -1;
+    }
+}
+
+static int get_cell(int x, int y)
+{
+    return calc_bound(y / CELL_SIZE, 0, CELLS - 1) * CELLS + calc_bound(x / CELL_SIZE, 0, CELLS - 1);
+}
+
+static void build_index(storage_index *index, building_type type)
+{
+    int counts[CELLS * CELLS] = {0};
+    for (int id = building_first_of_type(type); id; id = building_next_of_type(type, id)) {
+        building *b = building_get(id);
+        counts[get_cell(b->x, b->y)]++;
+    }
+    index->cell_start[0] = 0;
+    for (int cell = 0; cell < CELLS * CELLS; cell++) {
+        index->cell_start[cell + 1] = index->cell_start[cell] + counts[cell];
+        counts[cell] = index->cell_start[cell];
+    }
+    for (int id = building_first_of_type(type); id; id = building_next_of_type(type, id)) {
+        building *b = building_get(id);
+        index->ids[counts[get_cell(b->x, b->y)]++] = id;
+    }
+}
+
+static void update_index(void)
+{
+    if (data.is_valid && data.type_index_version == building_type_index_version()) {
+        return;
+    }
+    build_index(&data.index[INDEX_WAREHOUSE], BUILDING_WAREHOUSE);
+    build_index(&data.index[INDEX_WAREHOUSE_SPACE], BUILDING_WAREHOUSE_SPACE);
+    build_index(&data.index[INDEX_GRANARY], BUILDING_GRANARY);
+    data.type_index_version = building_type_index_version();
+    data.is_valid = 1;
+}
+
+static int distance_to_cell(int x, int y, int cell_x, int cell_y)
+{
+    int dx = 0;
+    int dy = 0;
+    if (x < cell_x * CELL_SIZE) {
+        dx = cell_x * CELL_SIZE - x;
+    } else if (x >= (cell_x + 1) * CELL_SIZE) {
+        dx = x - (cell_x + 1) * CELL_SIZE + 1;
+    }
+    if (y < cell_y * CELL_SIZE) {
+        dy = cell_y * CELL_SIZE - y;
+    } else if (y >= (cell_y + 1) * CELL_SIZE) {
+        dy = y - (cell_y + 1) * CELL_SIZE + 1;
+    }
+    return dx > dy ? dx : dy;
+}
+
+int building_storage_index_find_nearest(building_type type, int x, int y, int slack, int max_distance,
+                                        building_storage_distance_function distance, void *distance_data)
+{
+    int index_id = get_index(type);
+    if (index_id < 0) {
+        return 0;
+    }
+    update_index();
+    const storage_index *index = &data.index[index_id];
+
+    int min_distance = max_distance;
+    int min_building_id = 0;
+    int center_x = calc_bound(x / CELL_SIZE, 0, CELLS - 1);
+    int center_y = calc_bound(y / CELL_SIZE, 0, CELLS - 1);
+    for (int ring = 0; ring < CELLS; ring++) {
+        // every tile in this ring of cells is at least this far away
+        if (ring > 0 && (ring - 1) * CELL_SIZE + 1 - slack > min_distance) {
+            break;
+        }
+        for (int cell_y = center_y - ring; cell_y <= center_y + ring; cell_y++) {
+            if (cell_y < 0 || cell_y >= CELLS) {
+                continue;
+            }
+            // only the ring itself: whole rows at the top and bottom, the two ends in between
+            int step = ring && cell_y != center_y - ring && cell_y != center_y + ring ? 2 * ring : 1;
+            for (int cell_x = center_x - ring; cell_x <= center_x + ring; cell_x += step) {
+                if (cell_x < 0 || cell_x >= CELLS) {
+                    continue;
+                }
+                int cell = cell_y * CELLS + cell_x;
+                if (index->cell_start[cell] == index->cell_start[cell + 1] ||
+                    distance_to_cell(x, y, cell_x, cell_y) - slack > min_distance) {
+                    continue;
+                }
+                for (int i = index->cell_start[cell]; i < index->cell_start[cell + 1]; i++) {
+                    int building_id = index->ids[i];
+                    int dist = distance(building_get(building_id), distance_data);
+                    if (dist < min_distance ||
+                        (min_building_id && dist == min_distance && building_id < min_building_id)) {
+                        min_distance = dist;
+                        min_building_id = building_id;
+                    }
+                }
+            }
+        }
+    }
+    return min_building_id;
+}
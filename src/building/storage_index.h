@@ -0,0 +1,37 @@
+#ifndef BUILDING_STORAGE_INDEX_H
+#define BUILDING_STORAGE_INDEX_H
+
+#include "building/building.h"
+
+/**
+ * @file
+ * Spatial index of warehouses, warehouse spaces and granaries for nearest storage searches
+ */
+
+/**
+ * Distance function for a storage candidate
+ * @param b Candidate building
+ * @param data Data passed to the search
+ * @return Distance to the building, or at least max_distance if the building is not a candidate
+ */
+typedef int (*building_storage_distance_function)(building *b, void *data);
+
+/**
+ * Finds the storage building with the lowest distance, the lowest id when tied, like a scan over
+ * all buildings of the type in id order that keeps the first building with a lower distance.
+ * Buildings are visited from near to far, and the search stops as soon as no building further away
+ * can have a lower distance, so the distance function is not called for every building.
+ * @param type Type to search: BUILDING_WAREHOUSE, BUILDING_WAREHOUSE_SPACE or BUILDING_GRANARY
+ * @param x X position to search from
+ * @param y Y position to search from
+ * @param slack How much lower the distance can be than the tile distance between (x, y) and the
+ *              building's own tile
+ * @param max_distance Only buildings with a distance below this are returned
+ * @param distance Distance function
+ * @param data Data to pass to the distance function
+ * @return Building id, or 0 if no building had a distance below max_distance
+ */
+int building_storage_index_find_nearest(building_type type, int x, int y, int slack, int max_distance,
+                                        building_storage_distance_function distance, void *data);
+
+#endif // BUILDING_STORAGE_INDEX_H
@@ -3,6 +3,7 @@
 #include "building/count.h"
 #include "building/model.h"
 #include "building/storage.h"
+#include "building/storage_index.h"
 #include "city/buildings.h"
 #include "city/finance.h"
 #include "city/military.h"
@@ -196,16 +197,26 @@ void building_warehouse_space_remove_export(building *space, int resource)
     building_warehouse_space_set_image(space, resource);
 }
 
+// Visits every warehouse once, starting after the last used one and wrapping around to the lowest id
+static int next_warehouse_round_robin(int building_id, int last_used_id, int *wrapped)
+{
+    int next_id = building_next_of_type(BUILDING_WAREHOUSE, building_id);
+    if (!next_id && !*wrapped) {
+        *wrapped = 1;
+        next_id = building_first_of_type(BUILDING_WAREHOUSE);
+    }
+    return *wrapped && next_id > last_used_id ? 0 : next_id;
+}
+
 void building_warehouses_add_resource(int resource, int amount)
 {
-    int building_id = city_resource_last_used_warehouse();
-    for (int i = 1; i < MAX_BUILDINGS && amount > 0; i++) {
-        building_id++;
-        if (building_id >= MAX_BUILDINGS) {
-            building_id = 1;
-        }
+    int last_used_id = city_resource_last_used_warehouse();
+    int wrapped = 0;
+    for (int building_id = next_warehouse_round_robin(last_used_id, last_used_id, &wrapped);
+         building_id && amount > 0;
+         building_id = next_warehouse_round_robin(building_id, last_used_id, &wrapped)) {
         building *b = building_get(building_id);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_WAREHOUSE) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             city_resource_set_last_used_warehouse(building_id);
             while (amount && building_warehouse_add_resource(b, resource)) {
                 amount--;
@@ -217,15 +228,14 @@ void building_warehouses_add_resource(int resource, int amount)
 int building_warehouses_remove_resource(int resource, int amount)
 {
     int amount_left = amount;
-    int building_id = city_resource_last_used_warehouse();
+    int last_used_id = city_resource_last_used_warehouse();
+    int wrapped = 0;
     // first go for non-getting warehouses
-    for (int i = 1; i < MAX_BUILDINGS && amount_left > 0; i++) {
-        building_id++;
-        if (building_id >= MAX_BUILDINGS) {
-            building_id = 1;
-        }
+    for (int building_id = next_warehouse_round_robin(last_used_id, last_used_id, &wrapped);
+         building_id && amount_left > 0;
+         building_id = next_warehouse_round_robin(building_id, last_used_id, &wrapped)) {
         building *b = building_get(building_id);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_WAREHOUSE) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             if (building_storage_get(b->storage_id)->resource_state[resource] != BUILDING_STORAGE_STATE_GETTING) {
                 city_resource_set_last_used_warehouse(building_id);
                 amount_left = building_warehouse_remove_resource(b, resource, amount_left);
@@ -233,13 +243,12 @@ int building_warehouses_remove_resource(int resource, int amount)
         }
     }
     // if that doesn't work, take it anyway
-    for (int i = 1; i < MAX_BUILDINGS && amount_left > 0; i++) {
-        building_id++;
-        if (building_id >= MAX_BUILDINGS) {
-            building_id = 1;
-        }
+    wrapped = 0;
+    for (int building_id = next_warehouse_round_robin(last_used_id, last_used_id, &wrapped);
+         building_id && amount_left > 0;
+         building_id = next_warehouse_round_robin(building_id, last_used_id, &wrapped)) {
         building *b = building_get(building_id);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_WAREHOUSE) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             city_resource_set_last_used_warehouse(building_id);
             amount_left = building_warehouse_remove_resource(b, resource, amount_left);
         }
@@ -247,48 +256,62 @@ int building_warehouses_remove_resource(int resource, int amount)
     return amount - amount_left;
 }
 
+typedef struct {
+    int src_building_id;
+    int x;
+    int y;
+    int resource;
+    int distance_from_entry;
+    int road_network_id;
+    int *understaffed;
+} storing_query;
+
+#define MAX_STORING_DISTANCE 10000
+
+static int get_distance_for_storing(building *b, void *data)
+{
+    const storing_query *query = data;
+    if (b->state != BUILDING_STATE_IN_USE) {
+        return MAX_STORING_DISTANCE;
+    }
+    if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != query->road_network_id) {
+        return MAX_STORING_DISTANCE;
+    }
+    building *building_dst = building_main(b);
+    if (query->src_building_id == building_dst->id) {
+        return MAX_STORING_DISTANCE;
+    }
+    const building_storage *s = building_storage_get(building_dst->storage_id);
+    if (s->resource_state[query->resource] == BUILDING_STORAGE_STATE_NOT_ACCEPTING || s->empty_all) {
+        return MAX_STORING_DISTANCE;
+    }
+    int pct_workers = calc_percentage(building_dst->num_workers, model_get_building(building_dst->type)->laborers);
+    if (pct_workers < 100) {
+        if (query->understaffed) {
+            *query->understaffed += 1;
+        }
+        return MAX_STORING_DISTANCE;
+    }
+    int dist;
+    if (b->subtype.warehouse_resource_id == RESOURCE_NONE) { // empty warehouse space
+        dist = calc_distance_with_penalty(b->x, b->y, query->x, query->y,
+            query->distance_from_entry, b->distance_from_entry);
+    } else if (b->subtype.warehouse_resource_id == query->resource && b->loads_stored < 4) {
+        dist = calc_distance_with_penalty(b->x, b->y, query->x, query->y,
+            query->distance_from_entry, b->distance_from_entry);
+    } else {
+        dist = 0;
+    }
+    return dist > 0 ? dist : MAX_STORING_DISTANCE;
+}
+
 int building_warehouse_for_storing(int src_building_id, int x, int y, int resource,
                                    int distance_from_entry, int road_network_id, int *understaffed,
                                    map_point *dst)
 {
-    int min_dist = 10000;
-    int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE_SPACE) {
-            continue;
-        }
-        if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != road_network_id) {
-            continue;
-        }
-        building *building_dst = building_main(b);
-        if (src_building_id == building_dst->id) {
-            continue;
-        }
-        const building_storage *s = building_storage_get(building_dst->storage_id);
-        if (s->resource_state[resource] == BUILDING_STORAGE_STATE_NOT_ACCEPTING || s->empty_all) {
-            continue;
-        }
-        int pct_workers = calc_percentage(building_dst->num_workers, model_get_building(building_dst->type)->laborers);
-        if (pct_workers < 100) {
-            if (understaffed) {
-                *understaffed += 1;
-            }
-            continue;
-        }
-        int dist;
-        if (b->subtype.warehouse_resource_id == RESOURCE_NONE) { // empty warehouse space
-            dist = calc_distance_with_penalty(b->x, b->y, x, y, distance_from_entry, b->distance_from_entry);
-        } else if (b->subtype.warehouse_resource_id == resource && b->loads_stored < 4) {
-            dist = calc_distance_with_penalty(b->x, b->y, x, y, distance_from_entry, b->distance_from_entry);
-        } else {
-            dist = 0;
-        }
-        if (dist > 0 && dist < min_dist) {
-            min_dist = dist;
-            min_building_id = i;
-        }
-    }
+    storing_query query = {src_building_id, x, y, resource, distance_from_entry, road_network_id, understaffed};
+    int min_building_id = building_storage_index_find_nearest(BUILDING_WAREHOUSE_SPACE, x, y, 0,
+        MAX_STORING_DISTANCE, get_distance_for_storing, &query);
     building *b = building_main(building_get(min_building_id));
     if (b->has_road_access == 1) {
         map_point_store_result(b->x, b->y, dst);
@@ -298,40 +321,50 @@ int building_warehouse_for_storing(int src_building_id, int x, int y, int resour
     return min_building_id;
 }
 
-int building_warehouse_for_getting(building *src, int resource, map_point *dst)
+typedef struct {
+    building *src;
+    int resource;
+} getting_query;
+
+#define MAX_GETTING_DISTANCE 10000
+// a space holds at most 4 loads, and each load makes the warehouse 4 tiles closer
+#define MAX_GETTING_BONUS (4 * 4 * 8)
+
+static int get_distance_for_getting(building *b, void *data)
 {
-    int min_dist = 10000;
-    building *min_building = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
-        building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE) {
-            continue;
-        }
-        if (i == src->id) {
-            continue;
-        }
-        int loads_stored = 0;
-        building *space = b;
-        const building_storage *s = building_storage_get(b->storage_id);
-        for (int t = 0; t < 8; t++) {
-            space = building_next(space);
-            if (space->id > 0 && space->loads_stored > 0) {
-                if (space->subtype.warehouse_resource_id == resource) {
-                    loads_stored += space->loads_stored;
-                }
-            }
-        }
-        if (loads_stored > 0 && s->resource_state[resource] != BUILDING_STORAGE_STATE_GETTING) {
-            int dist = calc_distance_with_penalty(b->x, b->y, src->x, src->y,
-                                                  src->distance_from_entry, b->distance_from_entry);
-            dist -= 4 * loads_stored;
-            if (dist < min_dist) {
-                min_dist = dist;
-                min_building = b;
+    const getting_query *query = data;
+    if (b->state != BUILDING_STATE_IN_USE) {
+        return MAX_GETTING_DISTANCE;
+    }
+    if (b->id == query->src->id) {
+        return MAX_GETTING_DISTANCE;
+    }
+    int loads_stored = 0;
+    building *space = b;
+    const building_storage *s = building_storage_get(b->storage_id);
+    for (int t = 0; t < 8; t++) {
+        space = building_next(space);
+        if (space->id > 0 && space->loads_stored > 0) {
+            if (space->subtype.warehouse_resource_id == query->resource) {
+                loads_stored += space->loads_stored;
             }
         }
     }
-    if (min_building) {
+    if (loads_stored <= 0 || s->resource_state[query->resource] == BUILDING_STORAGE_STATE_GETTING) {
+        return MAX_GETTING_DISTANCE;
+    }
+    int dist = calc_distance_with_penalty(b->x, b->y, query->src->x, query->src->y,
+                                          query->src->distance_from_entry, b->distance_from_entry);
+    return dist - 4 * loads_stored;
+}
+
+int building_warehouse_for_getting(building *src, int resource, map_point *dst)
+{
+    getting_query query = {src, resource};
+    int min_building_id = building_storage_index_find_nearest(BUILDING_WAREHOUSE, src->x, src->y,
+        MAX_GETTING_BONUS, MAX_GETTING_DISTANCE, get_distance_for_getting, &query);
+    if (min_building_id) {
+        building *min_building = building_get(min_building_id);
         map_point_store_result(min_building->road_access_x, min_building->road_access_y, dst);
         return min_building->id;
     } else {
@@ -348,9 +381,9 @@ static int determine_granary_accept_foods(int resources[RESOURCE_MAX_FOOD])
         resources[i] = 0;
     }
     int can_accept = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_GRANARY); i; i = building_next_of_type(BUILDING_GRANARY, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY || !b->has_road_access) {
+        if (b->state != BUILDING_STATE_IN_USE || !b->has_road_access) {
             continue;
         }
         int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
@@ -378,9 +411,9 @@ static int determine_granary_get_foods(int resources[RESOURCE_MAX_FOOD])
         resources[i] = 0;
     }
     int can_get = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_GRANARY); i; i = building_next_of_type(BUILDING_GRANARY, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY || !b->has_road_access) {
+        if (b->state != BUILDING_STATE_IN_USE || !b->has_road_access) {
             continue;
         }
         int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
@@ -166,7 +166,7 @@ void city_culture_calculate(void)
     city_data.culture.average_health = 0;
 
     int num_houses = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->house_size) {
             num_houses++;
@@ -137,7 +137,7 @@ void city_finance_estimate_taxes(void)
 {
     city_data.taxes.monthly.collected_plebs = 0;
     city_data.taxes.monthly.collected_patricians = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->house_size && b->house_tax_coverage) {
             int is_patrician = b->subtype.house_level >= HOUSE_SMALL_VILLA;
@@ -177,7 +177,7 @@ static void collect_monthly_taxes(void)
     for (int i = 0; i < MAX_HOUSE_LEVELS; i++) {
         city_data.population.at_level[i] = 0;
     }
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || !b->house_size) {
             continue;
@@ -282,7 +282,7 @@ static void reset_taxes(void)
     city_data.taxes.yearly.uncollected_patricians = 0;
 
     // reset tax income in building list
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->house_size) {
             b->tax_income_or_storage = 0;
@@ -51,7 +51,7 @@ static void cause_disease(int total_people)
     }
     tutorial_on_disease();
     // kill people who don't have access to a doctor
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->house_size && b->house_population) {
             if (!b->data.house.clinic) {
@@ -64,7 +64,7 @@ static void cause_disease(int total_people)
         }
     }
     // kill people in tents
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->house_size && b->house_population) {
             if (b->subtype.house_level <= HOUSE_LARGE_TENT) {
@@ -77,7 +77,7 @@ static void cause_disease(int total_people)
         }
     }
     // kill anyone
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->house_size && b->house_population) {
             people_to_kill -= b->house_population;
@@ -98,7 +98,7 @@ void city_health_update(void)
     }
     int total_population = 0;
     int healthy_population = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE || !b->house_size || !b->house_population) {
             continue;
@@ -171,9 +171,9 @@ void city_resource_calculate_warehouse_stocks(void)
         city_data.resource.space_in_warehouses[i] = 0;
         city_data.resource.stored_in_warehouses[i] = 0;
     }
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_WAREHOUSE); i; i = building_next_of_type(BUILDING_WAREHOUSE, i)) {
         building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_WAREHOUSE) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             b->has_road_access = 0;
             if (map_has_road_access(b->x, b->y, b->size, 0)) {
                 b->has_road_access = 1;
@@ -182,9 +182,10 @@ void city_resource_calculate_warehouse_stocks(void)
             }
         }
     }
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_WAREHOUSE_SPACE); i;
+         i = building_next_of_type(BUILDING_WAREHOUSE_SPACE, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE_SPACE) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         building *warehouse = building_main(b);
@@ -240,9 +241,9 @@ static void calculate_available_food(void)
     city_data.resource.granaries.understaffed = 0;
     city_data.resource.granaries.not_operating = 0;
     city_data.resource.granaries.not_operating_with_food = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_GRANARY); i; i = building_next_of_type(BUILDING_GRANARY, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_GRANARY) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         b->has_road_access = 0;
@@ -298,9 +299,9 @@ void city_resource_calculate_food_stocks_and_supply_wheat(void)
 {
     calculate_available_food();
     if (scenario_property_rome_supplies_wheat()) {
-        for (int i = 1; i < MAX_BUILDINGS; i++) {
+        for (int i = building_first_of_type(BUILDING_MARKET); i; i = building_next_of_type(BUILDING_MARKET, i)) {
             building *b = building_get(i);
-            if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_MARKET) {
+            if (b->state == BUILDING_STATE_IN_USE) {
                 b->data.market.inventory[INVENTORY_WHEAT] = 200;
             }
         }
@@ -338,7 +339,7 @@ void city_resource_consume_food(void)
     city_data.resource.food_types_eaten = 0;
     city_data.unused.unknown_00c0 = 0;
     int total_consumed = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state == BUILDING_STATE_IN_USE && b->house_size) {
             int num_types = model_get_house(b->subtype.house_level)->food_types;
@@ -13,6 +13,11 @@
 #define HALF_TILE_WIDTH_PIXELS 30
 #define HALF_TILE_HEIGHT_PIXELS 15
 
+// Tile rows that can draw into a band of the screen: large footprints reach down,
+// tall buildings and figures reach up. Both cover the margins of the whole viewport.
+#define BAND_MARGIN_ABOVE (11 * HALF_TILE_HEIGHT_PIXELS)
+#define BAND_MARGIN_BELOW (24 * HALF_TILE_HEIGHT_PIXELS)
+
 static const int X_DIRECTION_FOR_ORIENTATION[] = {1,  1, -1, -1};
 static const int Y_DIRECTION_FOR_ORIENTATION[] = {1, -1, -1,  1};
 
@@ -40,6 +45,24 @@ static struct {
 } data;
 
 static int view_to_grid_offset_lookup[VIEW_X_MAX][VIEW_Y_MAX];
+static int lookup_version;
+
+// Visible tiles in drawing order, rebuilt when the camera, viewport or lookup changes
+static struct {
+    view_draw_tile tiles[VIEW_X_MAX * VIEW_Y_MAX];
+    view_draw_tile valid_tiles[VIEW_X_MAX * VIEW_Y_MAX];
+    view_draw_row rows[VIEW_Y_MAX];
+    view_draw_list list;
+    int is_valid;
+    struct {
+        view_tile tile;
+        pixel_offset pixel;
+    } camera;
+    int viewport_x;
+    int viewport_y;
+    int width_tiles;
+    int height_tiles;
+} draw_list;
 
 static void check_camera_boundaries(void)
 {
@@ -76,6 +99,8 @@ static void reset_lookup(void)
 static void calculate_lookup(void)
 {
     reset_lookup();
+    draw_list.is_valid = 0;
+    lookup_version++;
     int y_view_start;
     int y_view_skip;
     int y_view_step;
@@ -513,13 +538,20 @@ void city_view_load_scenario_state(buffer *camera)
     data.camera.tile.y = buffer_read_i32(camera);
 }
 
-void city_view_foreach_map_tile(map_callback *callback)
+static void build_draw_list(void)
 {
+    int num_rows = 0;
+    int num_tiles = 0;
+    int num_valid_tiles = 0;
     int odd = 0;
     int y_view = data.camera.tile.y - 8;
     int y_graphic = data.viewport.y - 9 * HALF_TILE_HEIGHT_PIXELS - data.camera.pixel.y;
     for (int y = 0; y < data.viewport.height_tiles + 21; y++) {
         if (y_view >= 0 && y_view < VIEW_Y_MAX) {
+            view_draw_row *row = &draw_list.rows[num_rows++];
+            row->y = y_graphic;
+            row->first_tile = num_tiles;
+            row->first_valid_tile = num_valid_tiles;
             int x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
             if (odd) {
                 x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
@@ -529,119 +561,110 @@ void city_view_foreach_map_tile(map_callback *callback)
             int x_view = data.camera.tile.x - 4;
             for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
                 if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                    int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                    callback(x_graphic, y_graphic, grid_offset);
+                    view_draw_tile *tile = &draw_list.tiles[num_tiles++];
+                    tile->x = x_graphic;
+                    tile->y = y_graphic;
+                    tile->grid_offset = view_to_grid_offset_lookup[x_view][y_view];
+                    if (tile->grid_offset >= 0) {
+                        draw_list.valid_tiles[num_valid_tiles++] = *tile;
+                    }
                 }
                 x_graphic += TILE_WIDTH_PIXELS;
                 x_view++;
             }
+            row->num_tiles = num_tiles - row->first_tile;
+            row->num_valid_tiles = num_valid_tiles - row->first_valid_tile;
         }
         odd = 1 - odd;
         y_graphic += HALF_TILE_HEIGHT_PIXELS;
         y_view++;
     }
+    draw_list.list.tiles = draw_list.tiles;
+    draw_list.list.num_tiles = num_tiles;
+    draw_list.list.valid_tiles = draw_list.valid_tiles;
+    draw_list.list.num_valid_tiles = num_valid_tiles;
+    draw_list.list.rows = draw_list.rows;
+    draw_list.list.num_rows = num_rows;
+}
+
+int city_view_lookup_version(void)
+{
+    return lookup_version;
+}
+
+const view_draw_list *city_view_get_draw_list(void)
+{
+    if (!draw_list.is_valid ||
+        draw_list.camera.tile.x != data.camera.tile.x || draw_list.camera.tile.y != data.camera.tile.y ||
+        draw_list.camera.pixel.x != data.camera.pixel.x || draw_list.camera.pixel.y != data.camera.pixel.y ||
+        draw_list.viewport_x != data.viewport.x || draw_list.viewport_y != data.viewport.y ||
+        draw_list.width_tiles != data.viewport.width_tiles || draw_list.height_tiles != data.viewport.height_tiles) {
+        build_draw_list();
+        draw_list.camera.tile = data.camera.tile;
+        draw_list.camera.pixel = data.camera.pixel;
+        draw_list.viewport_x = data.viewport.x;
+        draw_list.viewport_y = data.viewport.y;
+        draw_list.width_tiles = data.viewport.width_tiles;
+        draw_list.height_tiles = data.viewport.height_tiles;
+        draw_list.is_valid = 1;
+    }
+    return &draw_list.list;
+}
+
+void city_view_get_draw_rows_in_band(const view_draw_list *list, int y_start, int y_end, int *first_row, int *end_row)
+{
+    // rows are sorted from top to bottom
+    int row = 0;
+    while (row < list->num_rows && list->rows[row].y < y_start - BAND_MARGIN_ABOVE) {
+        row++;
+    }
+    *first_row = row;
+    while (row < list->num_rows && list->rows[row].y < y_end + BAND_MARGIN_BELOW) {
+        row++;
+    }
+    *end_row = row;
+}
+
+void city_view_foreach_map_tile(map_callback *callback)
+{
+    const view_draw_list *list = city_view_get_draw_list();
+    for (int i = 0; i < list->num_tiles; i++) {
+        const view_draw_tile *tile = &list->tiles[i];
+        callback(tile->x, tile->y, tile->grid_offset);
+    }
 }
 
 void city_view_foreach_valid_map_tile(map_callback *callback)
 {
-    int odd = 0;
-    int y_view = data.camera.tile.y - 8;
-    int y_graphic = data.viewport.y - 9 * HALF_TILE_HEIGHT_PIXELS - data.camera.pixel.y;
-    for (int y = 0; y < data.viewport.height_tiles + 21; y++) {
-        if (y_view >= 0 && y_view < VIEW_Y_MAX) {
-            int x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-            if (odd) {
-                x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-            } else {
-                x_graphic += data.viewport.x;
-            }
-            int x_view = data.camera.tile.x - 4;
-            for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                    int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                    if (grid_offset >= 0) {
-                        callback(x_graphic, y_graphic, grid_offset);
-                    }
-                }
-                x_graphic += TILE_WIDTH_PIXELS;
-                x_view++;
-            }
-        }
-        odd = 1 - odd;
-        y_graphic += HALF_TILE_HEIGHT_PIXELS;
-        y_view++;
+    const view_draw_list *list = city_view_get_draw_list();
+    for (int i = 0; i < list->num_valid_tiles; i++) {
+        const view_draw_tile *tile = &list->valid_tiles[i];
+        callback(tile->x, tile->y, tile->grid_offset);
+    }
+}
+
+static void foreach_valid_tile_in_row(const view_draw_list *list, const view_draw_row *row, map_callback *callback)
+{
+    const view_draw_tile *tiles = &list->valid_tiles[row->first_valid_tile];
+    for (int i = 0; i < row->num_valid_tiles; i++) {
+        callback(tiles[i].x, tiles[i].y, tiles[i].grid_offset);
     }
 }
 
 void city_view_foreach_valid_map_tile_row(map_callback *callback1, map_callback *callback2, map_callback *callback3)
 {
-    int odd = 0;
-    int y_view = data.camera.tile.y - 8;
-    int y_graphic = data.viewport.y - 9 * HALF_TILE_HEIGHT_PIXELS - data.camera.pixel.y;
-    int x_graphic, x_view;
-    for (int y = 0; y < data.viewport.height_tiles + 21; y++) {
-        if (y_view >= 0 && y_view < VIEW_Y_MAX) {
-            if (callback1) {
-                x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-                if (odd) {
-                    x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-                } else {
-                    x_graphic += data.viewport.x;
-                }
-                x_view = data.camera.tile.x - 4;
-                for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                    if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                        int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                        if (grid_offset >= 0) {
-                            callback1(x_graphic, y_graphic, grid_offset);
-                        }
-                    }
-                    x_graphic += TILE_WIDTH_PIXELS;
-                    x_view++;
-                }
-            }
-            if (callback2) {
-                x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-                if (odd) {
-                    x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-                } else {
-                    x_graphic += data.viewport.x;
-                }
-                x_view = data.camera.tile.x - 4;
-                for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                    if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                        int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                        if (grid_offset >= 0) {
-                            callback2(x_graphic, y_graphic, grid_offset);
-                        }
-                    }
-                    x_graphic += TILE_WIDTH_PIXELS;
-                    x_view++;
-                }
-            }
-            if (callback3) {
-                x_graphic = -(4 * TILE_WIDTH_PIXELS) - data.camera.pixel.x;
-                if (odd) {
-                    x_graphic += data.viewport.x - HALF_TILE_WIDTH_PIXELS;
-                } else {
-                    x_graphic += data.viewport.x;
-                }
-                x_view = data.camera.tile.x - 4;
-                for (int x = 0; x < data.viewport.width_tiles + 7; x++) {
-                    if (x_view >= 0 && x_view < VIEW_X_MAX) {
-                        int grid_offset = view_to_grid_offset_lookup[x_view][y_view];
-                        if (grid_offset >= 0) {
-                            callback3(x_graphic, y_graphic, grid_offset);
-                        }
-                    }
-                    x_graphic += TILE_WIDTH_PIXELS;
-                    x_view++;
-                }
-            }
+    const view_draw_list *list = city_view_get_draw_list();
+    for (int r = 0; r < list->num_rows; r++) {
+        const view_draw_row *row = &list->rows[r];
+        if (callback1) {
+            foreach_valid_tile_in_row(list, row, callback1);
+        }
+        if (callback2) {
+            foreach_valid_tile_in_row(list, row, callback2);
+        }
+        if (callback3) {
+            foreach_valid_tile_in_row(list, row, callback3);
         }
-        odd = 1 - odd;
-        y_graphic += HALF_TILE_HEIGHT_PIXELS;
-        y_view++;
     }
 }
 
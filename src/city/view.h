@@ -12,6 +12,31 @@ typedef struct {
     int y;
 } view_tile, pixel_offset;
 
+typedef struct {
+    int x;
+    int y;
+    int grid_offset;
+} view_draw_tile;
+
+typedef struct {
+    int y;
+    int first_tile;
+    int num_tiles;
+    int first_valid_tile;
+    int num_valid_tiles;
+} view_draw_row;
+
+// Tiles in the viewport in drawing order: rows from top to bottom, tiles from left to right.
+// Valid tiles are the ones on the map, every row has a range of both lists.
+typedef struct {
+    const view_draw_tile *tiles;
+    int num_tiles;
+    const view_draw_tile *valid_tiles;
+    int num_valid_tiles;
+    const view_draw_row *rows;
+    int num_rows;
+} view_draw_list;
+
 typedef void (map_callback)(int x, int y, int grid_offset);
 
 void city_view_init(void);
@@ -73,6 +98,16 @@ void city_view_foreach_valid_map_tile(map_callback *callback);
 
 void city_view_foreach_valid_map_tile_row(map_callback *callback1, map_callback *callback2, map_callback *callback3);
 
+// Changes every time the view tiles are mapped to the grid again: on rotation, or for another map
+int city_view_lookup_version(void);
+
+// The list is only rebuilt when the camera, viewport or orientation has changed since the last call.
+// Get it on the main thread; reading it is safe from several threads at once.
+const view_draw_list *city_view_get_draw_list(void);
+
+// Finds the rows with tiles that can draw into the screen rows y_start to y_end
+void city_view_get_draw_rows_in_band(const view_draw_list *list, int y_start, int y_end, int *first_row, int *end_row);
+
 void city_view_foreach_tile_in_range(int grid_offset, int size, int radius, map_callback *callback);
 
 void city_view_foreach_minimap_tile(
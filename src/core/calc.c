@@ -226,3 +226,17 @@ int32_t calc_bound(int32_t value, int32_t min, int32_t max)
         return value;
     }
 }
+
+int calc_lowest_set_bit(uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(value);
+#else
+    int bit = 0;
+    while (!(value & 1)) {
+        value >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
@@ -78,4 +78,11 @@ int calc_missile_direction(int x_from, int y_from, int x_to, int y_to);
  */
 int32_t calc_bound(int32_t value, int32_t min, int32_t max);
 
+/**
+ * Gets the position of the lowest bit that is set
+ * @param value Value, must not be 0
+ * @return Bit position, 0 for the least significant bit
+ */
+int calc_lowest_set_bit(uint32_t value);
+
 #endif // CORE_CALC_H
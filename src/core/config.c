@@ -14,8 +14,11 @@ static const char *INI_FILENAME = "octavius.ini";
 static const char *ini_keys[] = {
     "gameplay_fix_immigration",
     "gameplay_fix_100y_ghosts",
+    "gameplay_fix_route_limit",
     "screen_display_scale",
     "screen_cursor_scale",
+    "screen_cache_graphics",
+    "screen_external_image_cache_mb",
     "ui_octavius_ui",
     "ui_sidebar_info",
     "ui_show_intro_video",
@@ -41,7 +44,9 @@ static char string_values[CONFIG_STRING_MAX_ENTRIES][CONFIG_STRING_VALUE_MAX];
 
 static int default_values[CONFIG_MAX_ENTRIES] = {
     [CONFIG_SCREEN_DISPLAY_SCALE] = 100,
-    [CONFIG_SCREEN_CURSOR_SCALE] = 100
+    [CONFIG_SCREEN_CURSOR_SCALE] = 100,
+    [CONFIG_SCREEN_CACHE_GRAPHICS] = 1,
+    [CONFIG_SCREEN_EXTERNAL_IMAGE_CACHE_MB] = 32
 };
 static const char default_string_values[CONFIG_STRING_MAX_ENTRIES][CONFIG_STRING_VALUE_MAX];
 
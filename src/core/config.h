@@ -6,8 +6,11 @@
 typedef enum {
     CONFIG_GP_FIX_IMMIGRATION_BUG,
     CONFIG_GP_FIX_100_YEAR_GHOSTS,
+    CONFIG_GP_FIX_ROUTE_LIMIT,
     CONFIG_SCREEN_DISPLAY_SCALE,
     CONFIG_SCREEN_CURSOR_SCALE,
+    CONFIG_SCREEN_CACHE_GRAPHICS,
+    CONFIG_SCREEN_EXTERNAL_IMAGE_CACHE_MB,
     CONFIG_UI_OCTAVIUS_UI,
     CONFIG_UI_SIDEBAR_INFO,
     CONFIG_UI_SHOW_INTRO_VIDEO,
@@ -84,3 +84,77 @@ int file_remove(const char *filename)
 {
     return platform_file_manager_remove_file(filename);
 }
+
+int file_rename(const char *old_filename, const char *new_filename)
+{
+    return platform_file_manager_rename_file(old_filename, new_filename);
+}
+
+int file_get_info(const char *filename, int64_t *size, int64_t *modified_time)
+{
+    FILE *fp = file_open(filename, "rb");
+    if (!fp) {
+        return 0;
+    }
+    int result = platform_file_manager_get_file_info(fp, size, modified_time);
+    file_close(fp);
+    return result;
+}
+
+static int read_contents(FILE *fp, file_contents *contents)
+{
+    if (fseek(fp, 0, SEEK_END) != 0) {
+        return 0;
+    }
+    long size = ftell(fp);
+    if (size <= 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        return 0;
+    }
+    uint8_t *data = malloc((size_t) size);
+    if (!data) {
+        return 0;
+    }
+    if (fread(data, 1, (size_t) size, fp) != (size_t) size) {
+        free(data);
+        return 0;
+    }
+    contents->data = data;
+    contents->size = (size_t) size;
+    contents->is_mapped = 0;
+    return 1;
+}
+
+int file_map_contents(const char *filename, file_contents *contents)
+{
+    contents->data = 0;
+    contents->size = 0;
+    contents->is_mapped = 0;
+    FILE *fp = file_open(filename, "rb");
+    if (!fp) {
+        return 0;
+    }
+    size_t size;
+    void *data = platform_file_manager_map_file(fp, &size);
+    int result = 1;
+    if (data) {
+        contents->data = data;
+        contents->size = size;
+        contents->is_mapped = 1;
+    } else {
+        result = read_contents(fp, contents);
+    }
+    file_close(fp);
+    return result;
+}
+
+void file_unmap_contents(file_contents *contents)
+{
+    if (contents->is_mapped) {
+        platform_file_manager_unmap_file((void *) contents->data, contents->size);
+    } else {
+        free((void *) contents->data);
+    }
+    contents->data = 0;
+    contents->size = 0;
+    contents->is_mapped = 0;
+}
@@ -18,6 +18,12 @@
 
 #define FILE_NAME_MAX 300
 
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    int is_mapped;
+} file_contents;
+
 /**
  * Wrapper for fopen converting filename to path in current working directory
  * @param filename Filename
@@ -77,4 +83,36 @@ int file_exists(const char *filename, int localizable);
  */
 int file_remove(const char *filename);
 
+/**
+ * Rename a file, replacing the new file if it exists
+ * @param old_filename Current name of the file
+ * @param new_filename New name of the file
+ * @return boolean true if the file was renamed, false if it failed or the platform does not support it
+ */
+int file_rename(const char *old_filename, const char *new_filename);
+
+/**
+ * Gets the size and modification time of a file
+ * @param filename Filename
+ * @param size OUT: size of the file in bytes
+ * @param modified_time OUT: time of the last modification, in seconds
+ * @return boolean true if the information is available, false otherwise
+ */
+int file_get_info(const char *filename, int64_t *size, int64_t *modified_time);
+
+/**
+ * Makes the contents of a file available in memory. The file is memory-mapped
+ * when the platform supports it, otherwise it is read into an allocated buffer.
+ * @param filename Filename
+ * @param contents OUT: file contents, release with file_unmap_contents()
+ * @return boolean true on success, false if the file could not be read
+ */
+int file_map_contents(const char *filename, file_contents *contents);
+
+/**
+ * Releases the file contents obtained with file_map_contents()
+ * @param contents File contents to release
+ */
+void file_unmap_contents(file_contents *contents);
+
 #endif // CORE_FILE_H
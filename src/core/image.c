@@ -1,10 +1,14 @@
 #include "image.h"
 
 #include "core/buffer.h"
+#include "core/config.h"
+#include "core/dir.h"
 #include "core/file.h"
 #include "core/io.h"
 #include "core/log.h"
+#include "graphics/blit.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -39,6 +43,13 @@
 
 #define NAME_SIZE 32
 
+#define DECODED_CACHE_VERSION 1
+
+#define MAX_EXTERNAL_CACHE_ENTRIES 64
+// keeps the budget plus one more image within an int
+#define MAX_EXTERNAL_CACHE_MB 1000
+#define EXTERNAL_SCRATCH_OFFSET 4000000
+
 enum {
     NO_EXTRA_FONT = 0,
     FULL_CHARSET_IN_FONT = 1,
@@ -122,6 +133,22 @@ static const char ENEMY_GRAPHICS_555[][NAME_SIZE] = {
 
 static const image DUMMY_IMAGE;
 
+static const char DECODED_CACHE_MAGIC[8] = "C3IMG32";
+
+// Decoded climate graphics, stored in native byte order: the header, the pixel offset
+// of every image (0 for external images) and then the 32-bit pixels
+typedef struct {
+    char magic[8];
+    int32_t version;
+    int32_t num_entries;
+    int64_t graphics_size;
+    int64_t graphics_time;
+    int64_t index_size;
+    int64_t index_time;
+    int32_t num_pixels;
+    int32_t unused;
+} decoded_cache_header;
+
 static struct {
     int current_climate;
     int is_editor;
@@ -134,10 +161,25 @@ static struct {
     image enemy[ENEMY_ENTRIES];
     image *font;
     color_t *main_data;
+    const color_t *main_pixels;
+    file_contents main_cache;
     color_t *empire_data;
     color_t *enemy_data;
     color_t *font_data;
     uint8_t *tmp_data;
+    // Decoded external images, the least recently used one is dropped when over the memory budget
+    struct {
+        struct {
+            int image_id;
+            color_t *pixels;
+            int size;
+            unsigned int last_used;
+        } entries[MAX_EXTERNAL_CACHE_ENTRIES];
+        unsigned int clock;
+        int bytes_used;
+        int hits;
+        int misses;
+    } external;
 } data = {.current_climate = -1};
 
 int image_init(void)
@@ -153,6 +195,8 @@ int image_init(void)
         free(data.tmp_data);
         return 0;
     }
+    data.main_pixels = data.main_data;
+    blit_init();
     return 1;
 }
 
@@ -216,19 +260,24 @@ static void read_header(buffer *buf)
     buffer_read_raw(buf, data.bitmaps, 20000);
 }
 
-static color_t to_32_bit(uint16_t c)
+static void convert_pixels(buffer *buf, int num_pixels, color_t *dst)
 {
-    return ((c & 0x7c00) << 9) | ((c & 0x7000) << 4) |
-           ((c & 0x3e0) << 6)  | ((c & 0x380) << 1) |
-           ((c & 0x1f) << 3)   | ((c & 0x1c) >> 2);
+    int available = (buf->size - buf->index) / 2;
+    if (available < 0) {
+        available = 0;
+    }
+    if (num_pixels > available) {
+        // pixels beyond the end of the file are black, like buffer_read_u16() would return
+        memset(&dst[available], 0, (num_pixels - available) * sizeof(color_t));
+        num_pixels = available;
+    }
+    blit_convert_555(dst, &buf->data[buf->index], num_pixels);
+    buffer_skip(buf, num_pixels * 2);
 }
 
 static int convert_uncompressed(buffer *buf, int buf_length, color_t *dst)
 {
-    for (int i = 0; i < buf_length; i += 2) {
-        *dst = to_32_bit(buffer_read_u16(buf));
-        dst++;
-    }
+    convert_pixels(buf, (buf_length + 1) / 2, dst);
     return buf_length / 2;
 }
 
@@ -246,9 +295,8 @@ static int convert_compressed(buffer *buf, int buf_length, color_t *dst)
         } else {
             // control = number of concrete pixels
             *dst++ = control;
-            for (int i = 0; i < control; i++) {
-                *dst++ = to_32_bit(buffer_read_u16(buf));
-            }
+            convert_pixels(buf, control, dst);
+            dst += control;
             dst_length += control + 1;
             buf_length -= control * 2 + 1;
         }
@@ -256,7 +304,7 @@ static int convert_compressed(buffer *buf, int buf_length, color_t *dst)
     return dst_length;
 }
 
-static void convert_images(image *images, int size, buffer *buf, color_t *dst)
+static int convert_images(image *images, int size, buffer *buf, color_t *dst)
 {
     color_t *start_dst = dst;
     dst++; // make sure img->offset > 0
@@ -278,6 +326,7 @@ static void convert_images(image *images, int size, buffer *buf, color_t *dst)
         img->draw.offset = img_offset;
         img->draw.uncompressed_length /= 2;
     }
+    return (int) (dst - start_dst);
 }
 
 static void load_empire(void)
@@ -300,6 +349,107 @@ static void fix_animation_offsets(void)
     data.main[image_group(GROUP_BUILDING_ENGINEERS_POST)].sprite_offset_y += 1;
 }
 
+static int get_decoded_cache_key(const char *filename_idx, const char *filename_bmp, decoded_cache_header *key)
+{
+    memset(key, 0, sizeof(decoded_cache_header));
+    memcpy(key->magic, DECODED_CACHE_MAGIC, sizeof(key->magic));
+    key->version = DECODED_CACHE_VERSION;
+    key->num_entries = MAIN_ENTRIES;
+    const char *path = dir_get_file(filename_bmp, MAY_BE_LOCALIZED);
+    if (!path || !file_get_info(path, &key->graphics_size, &key->graphics_time)) {
+        return 0;
+    }
+    path = dir_get_file(filename_idx, MAY_BE_LOCALIZED);
+    return path && file_get_info(path, &key->index_size, &key->index_time);
+}
+
+static void get_decoded_cache_filename(const char *filename_bmp, char *filename)
+{
+    snprintf(filename, FILE_NAME_MAX, "%s.cache", filename_bmp);
+}
+
+static void release_decoded_cache(void)
+{
+    if (data.main_cache.data) {
+        file_unmap_contents(&data.main_cache);
+    }
+    data.main_pixels = data.main_data;
+}
+
+static int load_decoded_cache(const char *filename, const decoded_cache_header *key)
+{
+    file_contents contents;
+    if (!file_map_contents(filename, &contents)) {
+        return 0;
+    }
+    decoded_cache_header header;
+    size_t offsets_size = MAIN_ENTRIES * sizeof(int32_t);
+    int valid = contents.size >= sizeof(header) + offsets_size;
+    if (valid) {
+        memcpy(&header, contents.data, sizeof(header));
+        decoded_cache_header expected = *key;
+        expected.num_pixels = header.num_pixels;
+        valid = memcmp(&header, &expected, sizeof(header)) == 0 &&
+            header.num_pixels > 0 && header.num_pixels <= MAIN_DATA_SIZE / (int) sizeof(color_t) &&
+            contents.size == sizeof(header) + offsets_size + header.num_pixels * sizeof(color_t);
+    }
+    if (!valid) {
+        file_unmap_contents(&contents);
+        return 0;
+    }
+    int32_t offsets[MAIN_ENTRIES];
+    memcpy(offsets, contents.data + sizeof(header), offsets_size);
+    for (int i = 0; i < MAIN_ENTRIES; i++) {
+        if (offsets[i] < 0 || offsets[i] > header.num_pixels) {
+            file_unmap_contents(&contents);
+            return 0;
+        }
+    }
+    for (int i = 0; i < MAIN_ENTRIES; i++) {
+        image *img = &data.main[i];
+        if (!img->draw.is_external) {
+            img->draw.offset = offsets[i];
+            img->draw.uncompressed_length /= 2;
+        }
+    }
+    release_decoded_cache();
+    data.main_cache = contents;
+    data.main_pixels = (const color_t *) (contents.data + sizeof(header) + offsets_size);
+    return 1;
+}
+
+static void save_decoded_cache(const char *filename, const decoded_cache_header *key)
+{
+    char tmp_filename[FILE_NAME_MAX];
+    snprintf(tmp_filename, FILE_NAME_MAX, "%s.tmp", filename);
+    FILE *fp = file_open(tmp_filename, "wb");
+    if (!fp) {
+        return;
+    }
+    int32_t offsets[MAIN_ENTRIES];
+    for (int i = 0; i < MAIN_ENTRIES; i++) {
+        offsets[i] = data.main[i].draw.is_external ? 0 : data.main[i].draw.offset;
+    }
+    int written = fwrite(key, sizeof(decoded_cache_header), 1, fp) == 1 &&
+        fwrite(offsets, sizeof(offsets), 1, fp) == 1 &&
+        fwrite(data.main_data, sizeof(color_t), (size_t) key->num_pixels, fp) == (size_t) key->num_pixels;
+    file_close(fp);
+    if (!written || !file_rename(tmp_filename, filename)) {
+        log_info("Unable to write graphics cache", filename, 0);
+        file_remove(tmp_filename);
+    }
+}
+
+static void clear_external_cache(void)
+{
+    for (int i = 0; i < MAX_EXTERNAL_CACHE_ENTRIES; i++) {
+        free(data.external.entries[i].pixels);
+        data.external.entries[i].pixels = 0;
+        data.external.entries[i].size = 0;
+    }
+    data.external.bytes_used = 0;
+}
+
 int image_load_climate(int climate_id, int is_editor, int force_reload)
 {
     if (climate_id == data.current_climate && is_editor == data.is_editor && !force_reload) {
@@ -318,13 +468,28 @@ int image_load_climate(int climate_id, int is_editor, int force_reload)
     read_header(&buf);
     buffer_init(&buf, &data.tmp_data[HEADER_SIZE], ENTRY_SIZE * MAIN_ENTRIES);
     read_index(&buf, data.main, MAIN_ENTRIES);
-
-    int data_size = io_read_file_into_buffer(filename_bmp, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
-    if (!data_size) {
-        return 0;
+    // external images are looked up by id, which now may point to another bitmap
+    clear_external_cache();
+
+    decoded_cache_header cache_key;
+    char cache_filename[FILE_NAME_MAX];
+    int use_cache = config_get(CONFIG_SCREEN_CACHE_GRAPHICS) &&
+        get_decoded_cache_key(filename_idx, filename_bmp, &cache_key);
+    if (use_cache) {
+        get_decoded_cache_filename(filename_bmp, cache_filename);
+    }
+    if (!use_cache || !load_decoded_cache(cache_filename, &cache_key)) {
+        int data_size = io_read_file_into_buffer(filename_bmp, MAY_BE_LOCALIZED, data.tmp_data, SCRATCH_DATA_SIZE);
+        if (!data_size) {
+            return 0;
+        }
+        release_decoded_cache();
+        buffer_init(&buf, data.tmp_data, data_size);
+        cache_key.num_pixels = convert_images(data.main, MAIN_ENTRIES, &buf, data.main_data);
+        if (use_cache) {
+            save_decoded_cache(cache_filename, &cache_key);
+        }
     }
-    buffer_init(&buf, data.tmp_data, data_size);
-    convert_images(data.main, MAIN_ENTRIES, &buf, data.main_data);
     data.current_climate = climate_id;
     data.is_editor = is_editor;
 
@@ -698,8 +863,80 @@ int image_load_enemy(int enemy_id)
     return 1;
 }
 
+static const color_t *get_cached_external_data(int image_id)
+{
+    for (int i = 0; i < MAX_EXTERNAL_CACHE_ENTRIES; i++) {
+        if (data.external.entries[i].pixels && data.external.entries[i].image_id == image_id) {
+            data.external.entries[i].last_used = ++data.external.clock;
+            data.external.hits++;
+            return data.external.entries[i].pixels;
+        }
+    }
+    data.external.misses++;
+    return 0;
+}
+
+static int evict_least_recently_used_external(void)
+{
+    int oldest = -1;
+    for (int i = 0; i < MAX_EXTERNAL_CACHE_ENTRIES; i++) {
+        if (data.external.entries[i].pixels &&
+            (oldest < 0 || data.external.entries[i].last_used < data.external.entries[oldest].last_used)) {
+            oldest = i;
+        }
+    }
+    if (oldest >= 0) {
+        free(data.external.entries[oldest].pixels);
+        data.external.entries[oldest].pixels = 0;
+        data.external.bytes_used -= data.external.entries[oldest].size;
+        data.external.entries[oldest].size = 0;
+    }
+    return oldest;
+}
+
+static const color_t *add_external_to_cache(int image_id, const color_t *pixels, int num_pixels)
+{
+    int size = num_pixels * (int) sizeof(color_t);
+    int budget_mb = config_get(CONFIG_SCREEN_EXTERNAL_IMAGE_CACHE_MB);
+    if (budget_mb < 0) {
+        budget_mb = 0;
+    } else if (budget_mb > MAX_EXTERNAL_CACHE_MB) {
+        budget_mb = MAX_EXTERNAL_CACHE_MB;
+    }
+    int budget = budget_mb * 1024 * 1024;
+    if (size > budget) {
+        return pixels;
+    }
+    while (data.external.bytes_used + size > budget && evict_least_recently_used_external() >= 0) {
+    }
+    int slot = -1;
+    for (int i = 0; i < MAX_EXTERNAL_CACHE_ENTRIES && slot < 0; i++) {
+        if (!data.external.entries[i].pixels) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        slot = evict_least_recently_used_external();
+    }
+    color_t *copy = malloc(size);
+    if (!copy) {
+        return pixels;
+    }
+    memcpy(copy, pixels, size);
+    data.external.entries[slot].image_id = image_id;
+    data.external.entries[slot].pixels = copy;
+    data.external.entries[slot].size = size;
+    data.external.entries[slot].last_used = ++data.external.clock;
+    data.external.bytes_used += size;
+    return copy;
+}
+
 static const color_t *load_external_data(int image_id)
 {
+    const color_t *cached = get_cached_external_data(image_id);
+    if (cached) {
+        return cached;
+    }
     image *img = &data.main[image_id];
     char filename[FILE_NAME_MAX] = "555/";
     strcpy(&filename[4], data.bitmaps[img->draw.bitmap_id]);
@@ -722,14 +959,23 @@ static const color_t *load_external_data(int image_id)
     }
     buffer buf;
     buffer_init(&buf, data.tmp_data, size);
-    color_t *dst = (color_t*) &data.tmp_data[4000000];
+    color_t *dst = (color_t*) &data.tmp_data[EXTERNAL_SCRATCH_OFFSET];
+    int num_pixels;
     // NB: isometric images are never external
     if (img->draw.is_fully_compressed) {
-        convert_compressed(&buf, img->draw.data_length, dst);
+        num_pixels = convert_compressed(&buf, img->draw.data_length, dst);
     } else {
-        convert_uncompressed(&buf, img->draw.data_length, dst);
+        num_pixels = convert_uncompressed(&buf, img->draw.data_length, dst);
     }
-    return dst;
+    // images that do not fit the budget are used from the scratch buffer, until the next load
+    return add_external_to_cache(image_id, dst, num_pixels);
+}
+
+void image_get_external_cache_stats(int *hits, int *misses, int *bytes_used)
+{
+    *hits = data.external.hits;
+    *misses = data.external.misses;
+    *bytes_used = data.external.bytes_used;
 }
 
 int image_group(int group)
@@ -774,7 +1020,7 @@ const color_t *image_data(int id)
         return NULL;
     }
     if (!data.main[id].draw.is_external) {
-        return &data.main_data[data.main[id].draw.offset];
+        return &data.main_pixels[data.main[id].draw.offset];
     } else if (id == image_group(GROUP_EMPIRE_MAP)) {
         return data.empire_data;
     } else {
@@ -790,7 +1036,7 @@ const color_t *image_data_letter(int letter_id)
         return &data.font_data[data.font[data.font_base_offset + letter_id - IMAGE_FONT_MULTIBYTE_OFFSET].draw.offset];
     } else if (letter_id < IMAGE_FONT_MULTIBYTE_OFFSET) {
         int image_id = data.group_image_ids[GROUP_FONT] + letter_id;
-        return &data.main_data[data.main[image_id].draw.offset];
+        return &data.main_pixels[data.main[image_id].draw.offset];
     } else {
         return NULL;
     }
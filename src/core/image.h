@@ -120,4 +120,12 @@ const color_t *image_data_letter(int letter_id);
  */
 const color_t *image_data_enemy(int id);
 
+/**
+ * Gets the statistics of the cache for external images
+ * @param hits OUT: number of times a cached image was used
+ * @param misses OUT: number of times an image had to be loaded from disk
+ * @param bytes_used OUT: memory used by the cached images
+ */
+void image_get_external_cache_stats(int *hits, int *misses, int *bytes_used);
+
 #endif // CORE_IMAGE_H
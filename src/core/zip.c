@@ -16,6 +16,10 @@ enum {
     PK_EOF = 773,
 };
 
+#define PK_HASH_BITS 12
+#define PK_HASH_SIZE (1 << PK_HASH_BITS)
+#define PK_MAX_COPY_LENGTH 516
+
 struct pk_token {
     int stop;
 
@@ -49,6 +53,15 @@ struct pk_comp_buffer {
     uint16_t analyze_index[8708];
     signed short long_matcher[518];
 
+    int level;
+    int max_chain_length;
+    int nice_copy_length;
+    int hash_insert_ptr;
+    int input_data_end;
+    int16_t hash_head[PK_HASH_SIZE];
+    int16_t hash_prev[8708];
+    int16_t pair_head[PK_HASH_SIZE];
+
     uint16_t codeword_values[774];
     uint8_t codeword_bits[774];
 };
@@ -114,6 +127,15 @@ static const uint8_t pk_copy_length_extra_bits[16] = {
     0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8,
 };
 
+static const struct {
+    int max_chain_length;
+    int nice_copy_length;
+} pk_levels[] = {
+    [ZIP_LEVEL_FASTEST] = {4, 16},
+    [ZIP_LEVEL_FAST] = {32, 64},
+    [ZIP_LEVEL_HIGH] = {256, PK_MAX_COPY_LENGTH},
+};
+
 static void pk_memcpy(uint8_t *dst, const uint8_t *src, int length)
 {
     for (int i = 0; i < length; i++) {
@@ -192,7 +214,8 @@ static void pk_implode_write_copy_length_offset(struct pk_comp_buffer *buf, stru
     }
 }
 
-static void pk_implode_determine_copy(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+static void pk_implode_determine_copy_exhaustive(
+    struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
 {
     uint8_t *input_ptr = &buf->input_data[input_index];
     int hash_value = 4 * input_ptr[0] + 5 * input_ptr[1];
@@ -342,6 +365,137 @@ static void pk_implode_determine_copy(struct pk_comp_buffer *buf, int input_inde
     // never reached
 }
 
+static unsigned int pk_hash3(const uint8_t *data)
+{
+    uint32_t value = (uint32_t) data[0] << 16 | (uint32_t) data[1] << 8 | data[2];
+    return (value * 2654435761u) >> (32 - PK_HASH_BITS);
+}
+
+static unsigned int pk_hash2(const uint8_t *data)
+{
+    uint32_t value = (uint32_t) data[0] << 8 | data[1];
+    return (value * 2654435761u) >> (32 - PK_HASH_BITS);
+}
+
+static void pk_implode_reset_hash(struct pk_comp_buffer *buf, int input_start)
+{
+    memset(buf->hash_head, 0xff, sizeof(buf->hash_head));
+    memset(buf->pair_head, 0xff, sizeof(buf->pair_head));
+    buf->hash_insert_ptr = input_start;
+}
+
+static int16_t pk_shift_hash_position(int16_t position)
+{
+    return position >= 4096 ? (int16_t) (position - 4096) : -1;
+}
+
+static void pk_implode_shift_hash(struct pk_comp_buffer *buf)
+{
+    for (int i = 0; i < PK_HASH_SIZE; i++) {
+        buf->hash_head[i] = pk_shift_hash_position(buf->hash_head[i]);
+        buf->pair_head[i] = pk_shift_hash_position(buf->pair_head[i]);
+    }
+    for (int i = 0; i < buf->hash_insert_ptr - 4096; i++) {
+        buf->hash_prev[i] = pk_shift_hash_position(buf->hash_prev[i + 4096]);
+    }
+    buf->hash_insert_ptr -= 4096;
+}
+
+static void pk_implode_insert_hash(struct pk_comp_buffer *buf, int input_index)
+{
+    for (int index = buf->hash_insert_ptr; index < input_index; index++) {
+        const uint8_t *data = &buf->input_data[index];
+        if (index + 2 < buf->input_data_end) {
+            unsigned int hash = pk_hash3(data);
+            buf->hash_prev[index] = buf->hash_head[hash];
+            buf->hash_head[hash] = (int16_t) index;
+        }
+        if (index + 1 < buf->input_data_end) {
+            buf->pair_head[pk_hash2(data)] = (int16_t) index;
+        }
+    }
+    if (input_index > buf->hash_insert_ptr) {
+        buf->hash_insert_ptr = input_index;
+    }
+}
+
+static int pk_match_length(const uint8_t *match, const uint8_t *input, int max_length)
+{
+    int length = 0;
+    // compare eight bytes at a time, memcpy keeps the loads free of alignment issues
+    while (length + 8 <= max_length) {
+        uint64_t a, b;
+        memcpy(&a, &match[length], 8);
+        memcpy(&b, &input[length], 8);
+        if (a != b) {
+            break;
+        }
+        length += 8;
+    }
+    while (length < max_length && match[length] == input[length]) {
+        length++;
+    }
+    return length;
+}
+
+static void pk_implode_determine_copy_hashed(
+    struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+{
+    copy->length = 0;
+    pk_implode_insert_hash(buf, input_index);
+
+    int max_length = buf->input_data_end - input_index;
+    if (max_length > PK_MAX_COPY_LENGTH) {
+        max_length = PK_MAX_COPY_LENGTH;
+    }
+    if (max_length < 2) {
+        return;
+    }
+    const uint8_t *input_ptr = &buf->input_data[input_index];
+    int min_match_index = input_index - buf->dictionary_size + 1;
+    int best_length = 0;
+    if (max_length >= 3) {
+        int chain_length = buf->max_chain_length;
+        int match_index = buf->hash_head[pk_hash3(input_ptr)];
+        while (match_index >= min_match_index && chain_length-- > 0) {
+            const uint8_t *match_ptr = &buf->input_data[match_index];
+            if (match_ptr[best_length] == input_ptr[best_length] && match_ptr[0] == input_ptr[0]) {
+                int length = pk_match_length(match_ptr, input_ptr, max_length);
+                if (length > best_length) {
+                    best_length = length;
+                    copy->offset = (uint16_t) (input_index - match_index - 1);
+                    if (length >= buf->nice_copy_length || length == max_length) {
+                        break;
+                    }
+                }
+            }
+            match_index = buf->hash_prev[match_index];
+        }
+    }
+    if (best_length < 3) {
+        // a two byte copy is only worth it for offsets that fit in 8 bits
+        int match_index = buf->pair_head[pk_hash2(input_ptr)];
+        if (match_index >= input_index - 256 && match_index >= min_match_index
+            && buf->input_data[match_index] == input_ptr[0]
+            && buf->input_data[match_index + 1] == input_ptr[1]) {
+            best_length = 2;
+            copy->offset = (uint16_t) (input_index - match_index - 1);
+        }
+    }
+    if (best_length >= 2) {
+        copy->length = best_length;
+    }
+}
+
+static void pk_implode_determine_copy(struct pk_comp_buffer *buf, int input_index, struct pk_copy_length_offset *copy)
+{
+    if (buf->level == ZIP_LEVEL_ORIGINAL) {
+        pk_implode_determine_copy_exhaustive(buf, input_index, copy);
+    } else {
+        pk_implode_determine_copy_hashed(buf, input_index, copy);
+    }
+}
+
 static int pk_implode_next_copy_is_better(
     struct pk_comp_buffer *buf, int offset, const struct pk_copy_length_offset *current_copy)
 {
@@ -403,7 +557,16 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
             input_end += 516; // eat the 516 leftovers anyway
         }
 
-        if (has_leftover_data == 0) {
+        // the 516 bytes after input_end are lookahead that is only compressed with the next block
+        buf->input_data_end = eof ? input_end : input_end + 516;
+
+        if (buf->level != ZIP_LEVEL_ORIGINAL) {
+            // hash chains are updated while searching, see pk_implode_insert_hash
+            if (has_leftover_data == 0) {
+                pk_implode_reset_hash(buf, input_ptr);
+                has_leftover_data++;
+            }
+        } else if (has_leftover_data == 0) {
             pk_implode_analyze_input(buf, input_ptr, input_end + 1);
             has_leftover_data++;
             if (buf->dictionary_size != 4096) {
@@ -455,6 +618,9 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
         if (!eof) {
             input_ptr -= 4096;
             pk_memcpy(buf->input_data, &buf->input_data[4096], buf->dictionary_size + 516);
+            if (buf->level != ZIP_LEVEL_ORIGINAL) {
+                pk_implode_shift_hash(buf);
+            }
         }
     }
 
@@ -467,12 +633,17 @@ static void pk_implode_data(struct pk_comp_buffer *buf)
 }
 
 static int pk_implode(pk_input_func *input_func, pk_output_func *output_func,
-                      struct pk_comp_buffer *buf, struct pk_token *token, int dictionary_size)
+                      struct pk_comp_buffer *buf, struct pk_token *token, int dictionary_size, zip_level level)
 {
     buf->input_func = input_func;
     buf->output_func = output_func;
     buf->dictionary_size = dictionary_size;
     buf->token = token;
+    buf->level = level;
+    if (level != ZIP_LEVEL_ORIGINAL) {
+        buf->max_chain_length = pk_levels[level].max_chain_length;
+        buf->nice_copy_length = pk_levels[level].nice_copy_length;
+    }
     if (dictionary_size == 1024) {
         buf->window_size = 4;
         buf->copy_offset_extra_mask = 0xf;
@@ -723,6 +894,15 @@ static void zip_output_func(uint8_t *buffer, int length, struct pk_token *token)
 int zip_compress(const void *input_buffer, int input_length,
                  void *output_buffer, int *output_length)
 {
+    return zip_compress_level(input_buffer, input_length, output_buffer, output_length, ZIP_LEVEL_DEFAULT);
+}
+
+int zip_compress_level(const void *input_buffer, int input_length,
+                       void *output_buffer, int *output_length, zip_level level)
+{
+    if (level < ZIP_LEVEL_FASTEST || level > ZIP_LEVEL_ORIGINAL) {
+        level = ZIP_LEVEL_DEFAULT;
+    }
     struct pk_token token;
     struct pk_comp_buffer *buf = (struct pk_comp_buffer *) malloc(sizeof(struct pk_comp_buffer));
 
@@ -738,7 +918,7 @@ int zip_compress(const void *input_buffer, int input_length,
     token.output_length = *output_length;
 
     int ok = 1;
-    int pk_error = pk_implode(zip_input_func, zip_output_func, buf, &token, 4096);
+    int pk_error = pk_implode(zip_input_func, zip_output_func, buf, &token, 4096, level);
     if (pk_error || token.stop) {
         log_error("COMP Error occurred while compressing.", 0, 0);
         ok = 0;
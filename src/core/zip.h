@@ -6,8 +6,17 @@
  * Compression functions.
  */
 
+typedef enum {
+    ZIP_LEVEL_FASTEST = 1,
+    ZIP_LEVEL_FAST = 2,
+    ZIP_LEVEL_HIGH = 3,
+    ZIP_LEVEL_ORIGINAL = 4
+} zip_level;
+
+#define ZIP_LEVEL_DEFAULT ZIP_LEVEL_FAST
+
 /**
- * Compresses the input buffer.
+ * Compresses the input buffer using the default level.
  * @param input_buffer Input buffer to compress
  * @param input_length Length of input buffer
  * @param output_buffer Output buffer to write the compressed data to
@@ -16,6 +25,21 @@
  */
 int zip_compress(const void *input_buffer, int input_length, void *output_buffer, int *output_length);
 
+/**
+ * Compresses the input buffer using the given level.
+ * All levels produce data that the original game can read: lower levels trade
+ * compression ratio for speed by searching fewer earlier matches,
+ * ZIP_LEVEL_ORIGINAL searches all of them, like the original game does.
+ * @param input_buffer Input buffer to compress
+ * @param input_length Length of input buffer
+ * @param output_buffer Output buffer to write the compressed data to
+ * @param output_length IN: available length of the output buffer, OUT: written bytes
+ * @param level Compression level
+ * @return boolean true on success, false on error
+ */
+int zip_compress_level(const void *input_buffer, int input_length,
+                       void *output_buffer, int *output_length, zip_level level);
+
 /**
  * Decompresses the input buffer
  * @param input_buffer Inputbuffer to decompress
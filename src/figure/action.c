@@ -20,6 +20,7 @@
 #include "figuretype/trader.h"
 #include "figuretype/wall.h"
 #include "figuretype/water.h"
+#include "game/profiler.h"
 
 static void figure_nobody_action(figure *f)
 {
@@ -124,7 +125,10 @@ void figure_action_handle(void)
                     f->targeted_by_figure_id = 0;
                 }
             }
-            figure_action_callbacks[f->type](f);
+            int type = f->type;
+            uint64_t start = game_profiler_start();
+            figure_action_callbacks[type](f);
+            game_profiler_record_figure(type, start);
             if (f->state == FIGURE_STATE_DEAD) {
                 figure_delete(f);
             }
@@ -152,7 +152,10 @@ int figure_combat_get_target_for_soldier(int x, int y, int max_distance)
 {
     int min_figure_id = 0;
     int min_distance = 10000;
-    for (int i = 1; i < MAX_FIGURES; i++) {
+    int ids[MAX_FIGURES];
+    int num_ids = map_figure_ids_within_distance(x, y, max_distance, ids);
+    for (int n = 0; n < num_ids; n++) {
+        int i = ids[n];
         figure *f = figure_get(i);
         if (figure_is_dead(f)) {
             continue;
@@ -189,7 +192,11 @@ int figure_combat_get_target_for_wolf(int x, int y, int max_distance)
 {
     int min_figure_id = 0;
     int min_distance = 10000;
-    for (int i = 1; i < MAX_FIGURES; i++) {
+    // figures further away than max_distance can never be returned
+    int ids[MAX_FIGURES];
+    int num_ids = map_figure_ids_within_distance(x, y, max_distance, ids);
+    for (int n = 0; n < num_ids; n++) {
+        int i = ids[n];
         figure *f = figure_get(i);
         if (figure_is_dead(f) || !f->type) {
             continue;
@@ -237,12 +244,12 @@ int figure_combat_get_target_for_enemy(int x, int y)
 {
     int min_figure_id = 0;
     int min_distance = 10000;
-    for (int i = 1; i < MAX_FIGURES; i++) {
+    for (int i = figure_next_legion_id(0); i; i = figure_next_legion_id(i)) {
         figure *f = figure_get(i);
         if (figure_is_dead(f)) {
             continue;
         }
-        if (!f->targeted_by_figure_id && figure_is_legion(f)) {
+        if (!f->targeted_by_figure_id) {
             int distance = calc_maximum_distance(x, y, f->x, f->y);
             if (distance < min_distance) {
                 min_distance = distance;
@@ -254,12 +261,8 @@ int figure_combat_get_target_for_enemy(int x, int y)
         return min_figure_id;
     }
     // no 'free' soldier found, take first one
-    for (int i = 1; i < MAX_FIGURES; i++) {
-        figure *f = figure_get(i);
-        if (figure_is_dead(f)) {
-            continue;
-        }
-        if (figure_is_legion(f)) {
+    for (int i = figure_next_legion_id(0); i; i = figure_next_legion_id(i)) {
+        if (!figure_is_dead(figure_get(i))) {
             return i;
         }
     }
@@ -273,8 +276,10 @@ int figure_combat_get_missile_target_for_soldier(figure *shooter, int max_distan
 
     int min_distance = max_distance;
     figure *min_figure = 0;
-    for (int i = 1; i < MAX_FIGURES; i++) {
-        figure *f = figure_get(i);
+    int ids[MAX_FIGURES];
+    int num_ids = map_figure_ids_within_distance(x, y, max_distance, ids);
+    for (int n = 0; n < num_ids; n++) {
+        figure *f = figure_get(ids[n]);
         if (figure_is_dead(f)) {
             continue;
         }
@@ -301,8 +306,10 @@ int figure_combat_get_missile_target_for_enemy(figure *enemy, int max_distance,
 
     figure *min_figure = 0;
     int min_distance = max_distance;
-    for (int i = 1; i < MAX_FIGURES; i++) {
-        figure *f = figure_get(i);
+    int ids[MAX_FIGURES];
+    int num_ids = map_figure_ids_within_distance(x, y, max_distance, ids);
+    for (int n = 0; n < num_ids; n++) {
+        figure *f = figure_get(ids[n]);
         if (figure_is_dead(f) || !f->type) {
             continue;
         }
@@ -2,6 +2,7 @@
 
 #include "building/building.h"
 #include "city/emperor.h"
+#include "core/calc.h"
 #include "core/random.h"
 #include "empire/city.h"
 #include "figure/name.h"
@@ -12,9 +13,16 @@
 
 #include <string.h>
 
+#define USED_ID_WORD_BITS 32
+#define USED_ID_WORDS ((MAX_FIGURES + USED_ID_WORD_BITS - 1) / USED_ID_WORD_BITS)
+
 static struct {
     int created_sequence;
     figure figures[MAX_FIGURES];
+    // ids known to be in use, so figure_create() can skip them
+    uint32_t used_ids[USED_ID_WORDS];
+    // ids of legion figures: their type is only set on creation
+    uint32_t legion_ids[USED_ID_WORDS];
 } data = {0};
 
 figure *figure_get(int id)
@@ -22,10 +30,61 @@ figure *figure_get(int id)
     return &data.figures[id];
 }
 
+static void set_id_bit(uint32_t *ids, int id, int value)
+{
+    if (value) {
+        ids[id / USED_ID_WORD_BITS] |= 1u << (id % USED_ID_WORD_BITS);
+    } else {
+        ids[id / USED_ID_WORD_BITS] &= ~(1u << (id % USED_ID_WORD_BITS));
+    }
+}
+
+static void set_used(int id, int used)
+{
+    set_id_bit(data.used_ids, id, used);
+}
+
+static int next_id_with_bit(const uint32_t *ids, uint32_t invert, int id)
+{
+    int next = id + 1;
+    if (next <= 0 || next >= MAX_FIGURES) {
+        return 0;
+    }
+    int word_index = next / USED_ID_WORD_BITS;
+    uint32_t word = (ids[word_index] ^ invert) & (~0u << (next % USED_ID_WORD_BITS));
+    while (!word) {
+        if (++word_index >= USED_ID_WORDS) {
+            return 0;
+        }
+        word = ids[word_index] ^ invert;
+    }
+    next = word_index * USED_ID_WORD_BITS + calc_lowest_set_bit(word);
+    return next < MAX_FIGURES ? next : 0;
+}
+
+static int next_unused_id(int id)
+{
+    return next_id_with_bit(data.used_ids, ~0u, id);
+}
+
+int figure_next_legion_id(int id)
+{
+    return next_id_with_bit(data.legion_ids, 0, id);
+}
+
+static void update_used_ids(void)
+{
+    for (int i = 0; i < MAX_FIGURES; i++) {
+        set_used(i, data.figures[i].state != 0);
+        set_id_bit(data.legion_ids, i, data.figures[i].state && figure_is_legion(&data.figures[i]));
+    }
+}
+
 figure *figure_create(figure_type type, int x, int y, direction_type dir)
 {
     int id = 0;
-    for (int i = 1; i < MAX_FIGURES; i++) {
+    for (int i = next_unused_id(0); i; i = next_unused_id(i)) {
+        set_used(i, 1);
         if (!data.figures[i].state) {
             id = i;
             break;
@@ -38,6 +97,7 @@ figure *figure_create(figure_type type, int x, int y, direction_type dir)
     f->state = FIGURE_STATE_ALIVE;
     f->faction_id = 1;
     f->type = type;
+    set_id_bit(data.legion_ids, id, figure_is_legion(f));
     f->use_cross_country = 0;
     f->is_friendly = 1;
     f->created_sequence = data.created_sequence++;
@@ -112,6 +172,8 @@ void figure_delete(figure *f)
     int figure_id = f->id;
     memset(f, 0, sizeof(figure));
     f->id = figure_id;
+    set_used(figure_id, 0);
+    set_id_bit(data.legion_ids, figure_id, 0);
 }
 
 int figure_is_dead(const figure *f)
@@ -141,6 +203,7 @@ void figure_init_scenario(void)
         data.figures[i].id = i;
     }
     data.created_sequence = 0;
+    update_used_ids();
 }
 
 static void figure_save(buffer *buf, const figure *f)
@@ -360,4 +423,5 @@ void figure_load_state(buffer *list, buffer *seq)
         figure_load(list, &data.figures[i]);
         data.figures[i].id = i;
     }
+    update_used_ids();
 }
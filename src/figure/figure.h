@@ -136,6 +136,13 @@ int figure_is_enemy(const figure *f);
 
 int figure_is_legion(const figure *f);
 
+/**
+ * Gets the next legion figure, to go over all legion figures in id order
+ * @param id Figure id to start after, 0 to start at the beginning
+ * @return Id of the next legion figure, or 0 if there is none
+ */
+int figure_next_legion_id(int id);
+
 int figure_is_herd(const figure *f);
 
 void figure_init_scenario(void);
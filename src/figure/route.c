@@ -1,49 +1,364 @@
 #include "route.h"
 
+#include "core/config.h"
+#include "map/grid.h"
 #include "map/routing.h"
 #include "map/routing_path.h"
+#include "map/routing_terrain.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 #define MAX_PATH_LENGTH 500
-#define MAX_ROUTES 600
+#define MAX_SAVED_ROUTES 600
+#define MAX_CACHED_ROUTES 64
+
+#define NUM_BLOCK_SIZES 6
+#define BLOCKS_PER_CHUNK 32
+#define NO_BLOCK -1
+
+static const int BLOCK_SIZES[NUM_BLOCK_SIZES] = {16, 32, 64, 128, 256, MAX_PATH_LENGTH};
+
+typedef struct {
+    int figure_id;
+    int block_size;
+    uint8_t *path;
+} route;
+
+typedef struct path_chunk {
+    struct path_chunk *next;
+} path_chunk;
+
+typedef struct {
+    int in_use;
+    int source_offset;
+    int destination_offset;
+    int terrain_usage;
+    int terrain_version;
+    int can_travel;
+    int path_length;
+    unsigned int last_used;
+    uint8_t path[MAX_PATH_LENGTH];
+} cached_route;
 
 static struct {
-    int figure_ids[MAX_ROUTES];
-    uint8_t direction_paths[MAX_ROUTES][MAX_PATH_LENGTH];
+    route *routes;
+    int size;
+    uint32_t *free_ids;
+    int first_free_word;
+    struct {
+        path_chunk *chunks;
+        uint8_t *free_blocks[NUM_BLOCK_SIZES];
+    } pool;
+    uint8_t calculated_path[MAX_PATH_LENGTH];
+    struct {
+        cached_route routes[MAX_CACHED_ROUTES];
+        unsigned int use_counter;
+    } cache;
 } data;
 
-void figure_route_clear_all(void)
+static uint8_t *get_next_free_block(const uint8_t *block)
+{
+    uint8_t *next;
+    memcpy(&next, block, sizeof(uint8_t *));
+    return next;
+}
+
+static void release_block(int block_size, uint8_t *block)
+{
+    memcpy(block, &data.pool.free_blocks[block_size], sizeof(uint8_t *));
+    data.pool.free_blocks[block_size] = block;
+}
+
+static uint8_t *allocate_block(int block_size)
+{
+    if (!data.pool.free_blocks[block_size]) {
+        int size = BLOCK_SIZES[block_size];
+        path_chunk *chunk = (path_chunk *) malloc(sizeof(path_chunk) + BLOCKS_PER_CHUNK * size);
+        if (!chunk) {
+            return 0;
+        }
+        chunk->next = data.pool.chunks;
+        data.pool.chunks = chunk;
+        uint8_t *blocks = (uint8_t *) (chunk + 1);
+        for (int i = BLOCKS_PER_CHUNK - 1; i >= 0; i--) {
+            release_block(block_size, &blocks[i * size]);
+        }
+    }
+    uint8_t *block = data.pool.free_blocks[block_size];
+    data.pool.free_blocks[block_size] = get_next_free_block(block);
+    return block;
+}
+
+static void free_pool(void)
+{
+    while (data.pool.chunks) {
+        path_chunk *next = data.pool.chunks->next;
+        free(data.pool.chunks);
+        data.pool.chunks = next;
+    }
+    for (int i = 0; i < NUM_BLOCK_SIZES; i++) {
+        data.pool.free_blocks[i] = 0;
+    }
+}
+
+static int get_block_size(int length)
+{
+    for (int i = 0; i < NUM_BLOCK_SIZES; i++) {
+        if (length <= BLOCK_SIZES[i]) {
+            return i;
+        }
+    }
+    return NO_BLOCK;
+}
+
+/**
+ * Makes sure the route can store a path of the given length. The bytes after the end of a
+ * shorter path are left as they were, since saved games contain them.
+ */
+static int reserve_path(route *r, int length)
+{
+    if (r->block_size != NO_BLOCK && length <= BLOCK_SIZES[r->block_size]) {
+        return 1;
+    }
+    int block_size = get_block_size(length);
+    uint8_t *block = block_size == NO_BLOCK ? 0 : allocate_block(block_size);
+    if (!block) {
+        return 0;
+    }
+    int old_size = 0;
+    if (r->block_size != NO_BLOCK) {
+        old_size = BLOCK_SIZES[r->block_size];
+        memcpy(block, r->path, old_size);
+        release_block(r->block_size, r->path);
+    }
+    memset(&block[old_size], 0, BLOCK_SIZES[block_size] - old_size);
+    r->block_size = block_size;
+    r->path = block;
+    return 1;
+}
+
+static void set_id_free(int id, int is_free)
 {
-    for (int i = 0; i < MAX_ROUTES; i++) {
-        data.figure_ids[i] = 0;
-        for (int j = 0; j < MAX_PATH_LENGTH; j++) {
-            data.direction_paths[i][j] = 0;
+    int word = id / 32;
+    uint32_t bit = 1u << (id % 32);
+    if (is_free) {
+        data.free_ids[word] |= bit;
+        if (word < data.first_free_word) {
+            data.first_free_word = word;
         }
+    } else {
+        data.free_ids[word] &= ~bit;
     }
 }
 
+static int grow_routes(void)
+{
+    int new_size = data.size ? data.size * 2 : (MAX_SAVED_ROUTES + 31) / 32 * 32;
+    route *routes = (route *) realloc(data.routes, new_size * sizeof(route));
+    if (!routes) {
+        return 0;
+    }
+    data.routes = routes;
+    uint32_t *free_ids = (uint32_t *) realloc(data.free_ids, new_size / 32 * sizeof(uint32_t));
+    if (!free_ids) {
+        return 0;
+    }
+    data.free_ids = free_ids;
+    for (int i = data.size; i < new_size; i++) {
+        data.routes[i].figure_id = 0;
+        data.routes[i].block_size = NO_BLOCK;
+        data.routes[i].path = 0;
+    }
+    for (int i = data.size / 32; i < new_size / 32; i++) {
+        data.free_ids[i] = 0xffffffff;
+    }
+    if (!data.size) {
+        // route 0 means "no route"
+        set_id_free(0, 0);
+    }
+    data.size = new_size;
+    return 1;
+}
+
+static void release_route(int path_id)
+{
+    data.routes[path_id].figure_id = 0;
+    set_id_free(path_id, 1);
+}
+
+static void clear_cache(void)
+{
+    memset(&data.cache, 0, sizeof(data.cache));
+}
+
+static void clear_routes(void)
+{
+    free_pool();
+    free(data.routes);
+    free(data.free_ids);
+    data.routes = 0;
+    data.free_ids = 0;
+    data.size = 0;
+    data.first_free_word = 0;
+    grow_routes();
+    clear_cache();
+}
+
+void figure_route_clear_all(void)
+{
+    clear_routes();
+}
+
+static int is_valid_route(int path_id)
+{
+    return path_id > 0 && path_id < data.size;
+}
+
 void figure_route_clean(void)
 {
-    for (int i = 0; i < MAX_ROUTES; i++) {
-        int figure_id = data.figure_ids[i];
-        if (figure_id > 0 && figure_id < MAX_FIGURES) {
-            const figure *f = figure_get(figure_id);
-            if (f->state != FIGURE_STATE_ALIVE || f->routing_path_id != i) {
-                data.figure_ids[i] = 0;
+    for (int word = 0; word < data.size / 32; word++) {
+        if (data.free_ids[word] == 0xffffffff) {
+            continue;
+        }
+        for (int i = word * 32; i < word * 32 + 32; i++) {
+            int figure_id = data.routes[i].figure_id;
+            if (figure_id > 0 && figure_id < MAX_FIGURES) {
+                const figure *f = figure_get(figure_id);
+                if (f->state != FIGURE_STATE_ALIVE || f->routing_path_id != i) {
+                    release_route(i);
+                }
             }
         }
     }
+    // routes that did not fit in the saved game have to be calculated again
+    for (int i = 1; i < MAX_FIGURES; i++) {
+        figure *f = figure_get(i);
+        if (f->state == FIGURE_STATE_ALIVE && f->routing_path_id >= MAX_SAVED_ROUTES &&
+            (!is_valid_route(f->routing_path_id) || data.routes[f->routing_path_id].figure_id != f->id)) {
+            f->routing_path_id = 0;
+        }
+    }
 }
 
 static int get_first_available(void)
 {
-    for (int i = 1; i < MAX_ROUTES; i++) {
-        if (data.figure_ids[i] == 0) {
-            return i;
+    while (1) {
+        for (int word = data.first_free_word; word < data.size / 32; word++) {
+            uint32_t free_ids = data.free_ids[word];
+            if (free_ids) {
+                data.first_free_word = word;
+                int id = word * 32;
+                while (!(free_ids & 1)) {
+                    free_ids >>= 1;
+                    id++;
+                }
+                if (id >= MAX_SAVED_ROUTES && !config_get(CONFIG_GP_FIX_ROUTE_LIMIT)) {
+                    // original game: all routes in use, the figure cannot move
+                    return 0;
+                }
+                return id;
+            }
+        }
+        data.first_free_word = data.size / 32;
+        if (!grow_routes()) {
+            return 0;
+        }
+    }
+}
+
+static int terrain_version(int terrain_usage)
+{
+    if (terrain_usage == TERRAIN_USAGE_WALLS) {
+        return map_routing_walls_version();
+    } else {
+        return map_routing_land_citizen_version();
+    }
+}
+
+static cached_route *get_cached_route(int source_offset, int destination_offset, int terrain_usage, int version)
+{
+    for (int i = 0; i < MAX_CACHED_ROUTES; i++) {
+        cached_route *route = &data.cache.routes[i];
+        if (route->in_use && route->source_offset == source_offset &&
+            route->destination_offset == destination_offset &&
+            route->terrain_usage == terrain_usage && route->terrain_version == version) {
+            route->last_used = ++data.cache.use_counter;
+            return route;
         }
     }
     return 0;
 }
 
+static cached_route *get_free_cached_route(void)
+{
+    cached_route *oldest = &data.cache.routes[0];
+    for (int i = 0; i < MAX_CACHED_ROUTES; i++) {
+        cached_route *route = &data.cache.routes[i];
+        if (!route->in_use || route->terrain_version != terrain_version(route->terrain_usage)) {
+            return route;
+        }
+        if (route->last_used < oldest->last_used) {
+            oldest = route;
+        }
+    }
+    return oldest;
+}
+
+static int calculate_path(const figure *f, int terrain_usage, uint8_t *path, int *path_length)
+{
+    int can_travel;
+    *path_length = 0;
+    if (terrain_usage == TERRAIN_USAGE_WALLS) {
+        can_travel = map_routing_can_travel_over_walls(f->x, f->y, f->destination_x, f->destination_y);
+        if (can_travel) {
+            *path_length = map_routing_get_path(path, f->x, f->y, f->destination_x, f->destination_y, 4);
+            if (*path_length <= 0) {
+                *path_length = map_routing_get_path(path, f->x, f->y, f->destination_x, f->destination_y, 8);
+            }
+        }
+    } else {
+        can_travel = map_routing_citizen_can_travel_over_road_garden(f->x, f->y,
+            f->destination_x, f->destination_y);
+        if (can_travel) {
+            *path_length = map_routing_get_path(path, f->x, f->y, f->destination_x, f->destination_y, 8);
+        }
+    }
+    return can_travel;
+}
+
+/**
+ * Finds a path over roads or walls, reusing the path of an earlier figure if possible.
+ * These routes depend on nothing but the routing terrain, so a cached route stays
+ * valid until the terrain grid is rebuilt.
+ */
+static int calculate_path_cached(const figure *f, int terrain_usage, uint8_t *path, int *path_length)
+{
+    int source_offset = map_grid_offset(f->x, f->y);
+    int destination_offset = map_grid_offset(f->destination_x, f->destination_y);
+    int version = terrain_version(terrain_usage);
+    cached_route *route = get_cached_route(source_offset, destination_offset, terrain_usage, version);
+    if (route) {
+        map_routing_count_cached_route();
+        memcpy(path, route->path, route->path_length);
+        *path_length = route->path_length;
+        return route->can_travel;
+    }
+    int can_travel = calculate_path(f, terrain_usage, path, path_length);
+
+    route = get_free_cached_route();
+    route->in_use = 1;
+    route->source_offset = source_offset;
+    route->destination_offset = destination_offset;
+    route->terrain_usage = terrain_usage;
+    route->terrain_version = version;
+    route->can_travel = can_travel;
+    route->path_length = *path_length;
+    route->last_used = ++data.cache.use_counter;
+    memcpy(route->path, path, *path_length);
+    return can_travel;
+}
+
 void figure_route_add(figure *f)
 {
     f->routing_path_id = 0;
@@ -53,20 +368,20 @@ void figure_route_add(figure *f)
     if (!path_id) {
         return;
     }
+    uint8_t *path = data.calculated_path;
     int path_length;
     if (f->is_boat) {
         if (f->is_boat == 2) { // flotsam
             map_routing_calculate_distances_water_flotsam(f->x, f->y);
-            path_length = map_routing_get_path_on_water(data.direction_paths[path_id],
-                f->destination_x, f->destination_y, 1);
+            path_length = map_routing_get_path_on_water(path, f->destination_x, f->destination_y, 1);
         } else {
             map_routing_calculate_distances_water_boat(f->x, f->y);
-            path_length = map_routing_get_path_on_water(data.direction_paths[path_id],
-                f->destination_x, f->destination_y, 0);
+            path_length = map_routing_get_path_on_water(path, f->destination_x, f->destination_y, 0);
         }
     } else {
         // land figure
         int can_travel;
+        path_length = -1;
         switch (f->terrain_usage) {
             case TERRAIN_USAGE_ENEMY:
                 can_travel = map_routing_noncitizen_can_travel_over_land(f->x, f->y,
@@ -81,48 +396,39 @@ void figure_route_add(figure *f)
                 }
                 break;
             case TERRAIN_USAGE_WALLS:
-                can_travel = map_routing_can_travel_over_walls(f->x, f->y,
-                    f->destination_x, f->destination_y);
+                can_travel = calculate_path_cached(f, TERRAIN_USAGE_WALLS, path, &path_length);
                 break;
             case TERRAIN_USAGE_ANIMAL:
                 can_travel = map_routing_noncitizen_can_travel_over_land(f->x, f->y,
                     f->destination_x, f->destination_y, -1, 5000);
                 break;
             case TERRAIN_USAGE_PREFER_ROADS:
-                can_travel = map_routing_citizen_can_travel_over_road_garden(f->x, f->y,
-                    f->destination_x, f->destination_y);
+                // the road part is the same route as for TERRAIN_USAGE_ROADS
+                can_travel = calculate_path_cached(f, TERRAIN_USAGE_ROADS, path, &path_length);
                 if (!can_travel) {
                     can_travel = map_routing_citizen_can_travel_over_land(f->x, f->y,
                         f->destination_x, f->destination_y);
+                    path_length = -1;
                 }
                 break;
             case TERRAIN_USAGE_ROADS:
-                can_travel = map_routing_citizen_can_travel_over_road_garden(f->x, f->y,
-                    f->destination_x, f->destination_y);
+                can_travel = calculate_path_cached(f, TERRAIN_USAGE_ROADS, path, &path_length);
                 break;
             default:
                 can_travel = map_routing_citizen_can_travel_over_land(f->x, f->y,
                     f->destination_x, f->destination_y);
                 break;
         }
-        if (can_travel) {
-            if (f->terrain_usage == TERRAIN_USAGE_WALLS) {
-                path_length = map_routing_get_path(data.direction_paths[path_id], f->x, f->y,
-                    f->destination_x, f->destination_y, 4);
-                if (path_length <= 0) {
-                    path_length = map_routing_get_path(data.direction_paths[path_id], f->x, f->y,
-                        f->destination_x, f->destination_y, 8);
-                }
-            } else {
-                path_length = map_routing_get_path(data.direction_paths[path_id], f->x, f->y,
-                    f->destination_x, f->destination_y, 8);
-            }
-        } else { // cannot travel
+        if (!can_travel) {
             path_length = 0;
+        } else if (path_length < 0) {
+            path_length = map_routing_get_path(path, f->x, f->y, f->destination_x, f->destination_y, 8);
         }
     }
-    if (path_length) {
-        data.figure_ids[path_id] = f->id;
+    if (path_length > 0 && reserve_path(&data.routes[path_id], path_length)) {
+        memcpy(data.routes[path_id].path, path, path_length);
+        data.routes[path_id].figure_id = f->id;
+        set_id_free(path_id, 0);
         f->routing_path_id = path_id;
         f->routing_path_length = path_length;
     }
@@ -131,8 +437,8 @@ void figure_route_add(figure *f)
 void figure_route_remove(figure *f)
 {
     if (f->routing_path_id > 0) {
-        if (data.figure_ids[f->routing_path_id] == f->id) {
-            data.figure_ids[f->routing_path_id] = 0;
+        if (is_valid_route(f->routing_path_id) && data.routes[f->routing_path_id].figure_id == f->id) {
+            release_route(f->routing_path_id);
         }
         f->routing_path_id = 0;
     }
@@ -140,21 +446,52 @@ void figure_route_remove(figure *f)
 
 int figure_route_get_direction(int path_id, int index)
 {
-    return data.direction_paths[path_id][index];
+    if (!is_valid_route(path_id)) {
+        return DIR_FIGURE_REROUTE;
+    }
+    if (index < 0 || index >= MAX_PATH_LENGTH) {
+        return DIR_FIGURE_REROUTE;
+    }
+    const route *r = &data.routes[path_id];
+    if (r->block_size == NO_BLOCK || index >= BLOCK_SIZES[r->block_size]) {
+        // never written, or trailing zeros (DIR_0_TOP) left out when loading
+        return 0;
+    }
+    return r->path[index];
 }
 
 void figure_route_save_state(buffer *figures, buffer *paths)
 {
-    for (int i = 0; i < MAX_ROUTES; i++) {
-        buffer_write_i16(figures, data.figure_ids[i]);
-        buffer_write_raw(paths, data.direction_paths[i], MAX_PATH_LENGTH);
+    static const uint8_t empty_path[MAX_PATH_LENGTH];
+    for (int i = 0; i < MAX_SAVED_ROUTES; i++) {
+        const route *r = i < data.size ? &data.routes[i] : 0;
+        int stored = r && r->block_size != NO_BLOCK ? BLOCK_SIZES[r->block_size] : 0;
+        buffer_write_i16(figures, r ? r->figure_id : 0);
+        if (stored) {
+            buffer_write_raw(paths, r->path, stored);
+        }
+        buffer_write_raw(paths, empty_path, MAX_PATH_LENGTH - stored);
     }
 }
 
 void figure_route_load_state(buffer *figures, buffer *paths)
 {
-    for (int i = 0; i < MAX_ROUTES; i++) {
-        data.figure_ids[i] = buffer_read_i16(figures);
-        buffer_read_raw(paths, data.direction_paths[i], MAX_PATH_LENGTH);
+    clear_routes();
+    uint8_t path[MAX_PATH_LENGTH];
+    for (int i = 0; i < MAX_SAVED_ROUTES; i++) {
+        route *r = &data.routes[i];
+        r->figure_id = buffer_read_i16(figures);
+        if (r->figure_id) {
+            set_id_free(i, 0);
+        }
+        buffer_read_raw(paths, path, MAX_PATH_LENGTH);
+        // zero is DIR_0_TOP, so a path in use keeps all its bytes
+        int length = MAX_PATH_LENGTH;
+        while (!r->figure_id && length > 0 && !path[length - 1]) {
+            length--;
+        }
+        if (length && reserve_path(r, length)) {
+            memcpy(r->path, path, length);
+        }
     }
 }
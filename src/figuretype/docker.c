@@ -90,9 +90,9 @@ static int get_closest_warehouse_for_import(int x, int y, int city_id, int dista
     }
     int min_distance = 10000;
     int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_WAREHOUSE); i; i = building_next_of_type(BUILDING_WAREHOUSE, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         if (!b->has_road_access || b->distance_from_entry <= 0) {
@@ -156,9 +156,9 @@ static int get_closest_warehouse_for_export(int x, int y, int city_id, int dista
     }
     int min_distance = 10000;
     int min_building_id = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_WAREHOUSE); i; i = building_next_of_type(BUILDING_WAREHOUSE, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_WAREHOUSE) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         if (!b->has_road_access || b->distance_from_entry <= 0) {
@@ -38,6 +38,20 @@ int game_file_load_saved_game(const char *filename);
  */
 int game_file_write_saved_game(const char *filename);
 
+/**
+ * Write saved game to disk on a background thread. The game state is copied
+ * first, so the game can continue while the file is being written.
+ * @param filename File to save to
+ * @return Boolean true if the save was started, false on failure
+ */
+int game_file_write_saved_game_in_background(const char *filename);
+
+/**
+ * Completes a saved game that was written in the background, once it is written
+ * @param wait Whether to wait for the background save to finish
+ */
+void game_file_finish_background_save(int wait);
+
 /**
  * Delete saved game
  * @param filename File to delete
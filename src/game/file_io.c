@@ -22,6 +22,7 @@
 #include "figure/name.h"
 #include "figure/route.h"
 #include "figure/trader.h"
+#include "game/system.h"
 #include "game/time.h"
 #include "game/tutorial.h"
 #include "map/aqueduct.h"
@@ -53,13 +54,17 @@
 
 static const int SAVE_GAME_VERSION = 0x66;
 
-static char compress_buffer[COMPRESS_BUFFER_SIZE];
-
 static int savegame_version;
 
 typedef struct {
     buffer buf;
     int compressed;
+    struct {
+        uint8_t *data;
+        int max_size;
+        int size;
+        int ok;
+    } output;
 } file_piece;
 
 typedef struct {
@@ -173,12 +178,29 @@ static struct {
     savegame_state state;
 } savegame_data = {0};
 
+static struct {
+    int num_pieces;
+    file_piece pieces[100];
+    FILE *fp;
+    char filename[FILE_NAME_MAX];
+    char temp_filename[FILE_NAME_MAX];
+    int pending;
+} background_save = {0};
+
 static void init_file_piece(file_piece *piece, int size, int compressed)
 {
     piece->compressed = compressed;
     void *data = malloc(size);
     memset(data, 0, size);
     buffer_init(&piece->buf, data, size);
+    if (compressed) {
+        // leave room for incompressible data, which grows a bit when imploded
+        piece->output.max_size = size + size / 4 + 64;
+        if (piece->output.max_size > COMPRESS_BUFFER_SIZE) {
+            piece->output.max_size = COMPRESS_BUFFER_SIZE;
+        }
+        piece->output.data = malloc(piece->output.max_size);
+    }
 }
 
 static buffer *create_scenario_piece(int size)
@@ -544,17 +566,6 @@ int game_file_io_write_scenario(const char *filename)
     return 1;
 }
 
-static int read_int32(FILE *fp)
-{
-    uint8_t data[4];
-    if (fread(&data, 1, 4, fp) != 4) {
-        return 0;
-    }
-    buffer buf;
-    buffer_init(&buf, data, 4);
-    return buffer_read_i32(&buf);
-}
-
 static void write_int32(FILE *fp, int value)
 {
     uint8_t data[4];
@@ -564,66 +575,107 @@ static void write_int32(FILE *fp, int value)
     fwrite(&data, 1, 4, fp);
 }
 
-static int read_compressed_chunk(FILE *fp, void *buffer, int bytes_to_read)
+static void compress_piece(void *pieces, int index)
 {
-    if (bytes_to_read > COMPRESS_BUFFER_SIZE) {
-        return 0;
-    }
-    int input_size = read_int32(fp);
-    if ((unsigned int) input_size == UNCOMPRESSED) {
-        if (fread(buffer, 1, bytes_to_read, fp) != bytes_to_read) {
-            return 0;
+    file_piece *piece = ((file_piece **) pieces)[index];
+    piece->output.size = piece->output.max_size;
+    piece->output.ok = piece->buf.size <= COMPRESS_BUFFER_SIZE && piece->output.data &&
+        zip_compress(piece->buf.data, piece->buf.size, piece->output.data, &piece->output.size);
+}
+
+static void compress_pieces(file_piece *pieces, int num_pieces, int in_parallel)
+{
+    // compress the largest pieces first so the work is spread evenly over the threads
+    file_piece *sorted[100];
+    int num_sorted = 0;
+    for (int i = 0; i < num_pieces; i++) {
+        file_piece *piece = &pieces[i];
+        if (!piece->compressed) {
+            continue;
         }
+        int j = num_sorted++;
+        while (j > 0 && sorted[j - 1]->buf.size < piece->buf.size) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = piece;
+    }
+    if (in_parallel) {
+        system_run_parallel(compress_piece, sorted, num_sorted);
     } else {
-        if (fread(compress_buffer, 1, input_size, fp) != input_size
-            || !zip_decompress(compress_buffer, input_size, buffer, &bytes_to_read)) {
-            return 0;
+        for (int i = 0; i < num_sorted; i++) {
+            compress_piece(sorted, i);
         }
     }
-    return 1;
 }
 
-static int write_compressed_chunk(FILE *fp, const void *buffer, int bytes_to_write)
+static int write_compressed_chunk(FILE *fp, const file_piece *piece)
 {
-    if (bytes_to_write > COMPRESS_BUFFER_SIZE) {
+    if (piece->buf.size > COMPRESS_BUFFER_SIZE) {
         return 0;
     }
-    int output_size = COMPRESS_BUFFER_SIZE;
-    if (zip_compress(buffer, bytes_to_write, compress_buffer, &output_size)) {
-        write_int32(fp, output_size);
-        fwrite(compress_buffer, 1, output_size, fp);
+    if (piece->output.ok) {
+        write_int32(fp, piece->output.size);
+        fwrite(piece->output.data, 1, piece->output.size, fp);
     } else {
         // unable to compress: write uncompressed
         write_int32(fp, UNCOMPRESSED);
-        fwrite(buffer, 1, bytes_to_write, fp);
+        fwrite(piece->buf.data, 1, piece->buf.size, fp);
     }
     return 1;
 }
 
-static int savegame_read_from_file(FILE *fp)
+static int read_piece(buffer *file, file_piece *piece, int is_last)
 {
-    for (int i = 0; i < savegame_data.num_pieces; i++) {
-        file_piece *piece = &savegame_data.pieces[i];
-        int result = 0;
-        if (piece->compressed) {
-            result = read_compressed_chunk(fp, piece->buf.data, piece->buf.size);
-        } else {
-            result = fread(piece->buf.data, 1, piece->buf.size, fp) == piece->buf.size;
+    int size = piece->buf.size;
+    if (piece->compressed) {
+        int input_size = buffer_read_i32(file);
+        if ((unsigned int) input_size != UNCOMPRESSED) {
+            if (file->overflow || input_size <= 0 || input_size > file->size - file->index) {
+                return 0;
+            }
+            // decompress straight from the file contents
+            const uint8_t *input = &file->data[file->index];
+            buffer_skip(file, input_size);
+            return zip_decompress(input, input_size, piece->buf.data, &size);
         }
-        // The last piece may be smaller than buf.size
-        if (!result && i != (savegame_data.num_pieces - 1)) {
+    }
+    int remaining = file->size - file->index;
+    if (file->overflow || size > remaining) {
+        if (!is_last || file->overflow) {
             return 0;
         }
+        // The last piece may be smaller than buf.size
+        size = remaining;
     }
+    // copy instead of pointing into the file contents: saving skips unknown bytes
+    // in some pieces, which should keep the values that were loaded
+    memcpy(piece->buf.data, &file->data[file->index], size);
+    buffer_skip(file, size);
     return 1;
 }
 
-static void savegame_write_to_file(FILE *fp)
+static int savegame_read_from_contents(const file_contents *contents, int offset)
 {
+    if (offset < 0 || (size_t) offset > contents->size) {
+        return 0;
+    }
+    buffer file;
+    buffer_init(&file, (uint8_t *) contents->data + offset, (int) (contents->size - offset));
     for (int i = 0; i < savegame_data.num_pieces; i++) {
-        file_piece *piece = &savegame_data.pieces[i];
+        if (!read_piece(&file, &savegame_data.pieces[i], i == savegame_data.num_pieces - 1)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void savegame_write_to_file(FILE *fp, const file_piece *pieces, int num_pieces)
+{
+    for (int i = 0; i < num_pieces; i++) {
+        const file_piece *piece = &pieces[i];
         if (piece->compressed) {
-            write_compressed_chunk(fp, piece->buf.data, piece->buf.size);
+            write_compressed_chunk(fp, piece);
         } else {
             fwrite(piece->buf.data, 1, piece->buf.size, fp);
         }
@@ -632,19 +684,17 @@ static void savegame_write_to_file(FILE *fp)
 
 int game_file_io_read_saved_game(const char *filename, int offset)
 {
+    game_file_io_finish_background_save(1);
     init_savegame_data();
 
     log_info("Loading saved game", filename, 0);
-    FILE *fp = file_open(dir_get_file(filename, NOT_LOCALIZED), "rb");
-    if (!fp) {
+    file_contents contents;
+    if (!file_map_contents(dir_get_file(filename, NOT_LOCALIZED), &contents)) {
         log_error("Unable to load game", 0, 0);
         return 0;
     }
-    if (offset) {
-        fseek(fp, offset, SEEK_SET);
-    }
-    int result = savegame_read_from_file(fp);
-    file_close(fp);
+    int result = savegame_read_from_contents(&contents, offset);
+    file_unmap_contents(&contents);
     if (!result) {
         log_error("Unable to load game", 0, 0);
         return 0;
@@ -655,6 +705,7 @@ int game_file_io_read_saved_game(const char *filename, int offset)
 
 int game_file_io_write_saved_game(const char *filename)
 {
+    game_file_io_finish_background_save(1);
     init_savegame_data();
 
     log_info("Saving game", filename, 0);
@@ -666,13 +717,85 @@ int game_file_io_write_saved_game(const char *filename)
         log_error("Unable to save game", 0, 0);
         return 0;
     }
-    savegame_write_to_file(fp);
+    compress_pieces(savegame_data.pieces, savegame_data.num_pieces, 1);
+    savegame_write_to_file(fp, savegame_data.pieces, savegame_data.num_pieces);
     file_close(fp);
     return 1;
 }
 
+static void take_background_snapshot(void)
+{
+    if (!background_save.num_pieces) {
+        for (int i = 0; i < savegame_data.num_pieces; i++) {
+            init_file_piece(&background_save.pieces[i],
+                savegame_data.pieces[i].buf.size, savegame_data.pieces[i].compressed);
+        }
+        background_save.num_pieces = savegame_data.num_pieces;
+    }
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        memcpy(background_save.pieces[i].buf.data, savegame_data.pieces[i].buf.data, savegame_data.pieces[i].buf.size);
+    }
+}
+
+static void write_background_save(void *unused)
+{
+    // this runs on another thread: it should only touch the snapshot
+    compress_pieces(background_save.pieces, background_save.num_pieces, 0);
+    savegame_write_to_file(background_save.fp, background_save.pieces, background_save.num_pieces);
+    file_close(background_save.fp);
+    background_save.fp = 0;
+}
+
+int game_file_io_write_saved_game_in_background(const char *filename)
+{
+    game_file_io_finish_background_save(1);
+    init_savegame_data();
+
+    log_info("Saving game in background", filename, 0);
+    savegame_version = SAVE_GAME_VERSION;
+    savegame_save_to_state(&savegame_data.state);
+    take_background_snapshot();
+
+    strncpy(background_save.filename, filename, FILE_NAME_MAX - 1);
+    snprintf(background_save.temp_filename, FILE_NAME_MAX, "%s.tmp", filename);
+    background_save.fp = file_open(background_save.temp_filename, "wb");
+    if (!background_save.fp) {
+        log_error("Unable to save game", 0, 0);
+        return 0;
+    }
+    background_save.pending = 1;
+    system_run_in_background(write_background_save, 0);
+    return 1;
+}
+
+void game_file_io_finish_background_save(int wait)
+{
+    if (!background_save.pending) {
+        return;
+    }
+    if (wait) {
+        system_wait_for_background_task();
+    } else if (system_background_task_running()) {
+        return;
+    }
+    background_save.pending = 0;
+    if (file_rename(background_save.temp_filename, background_save.filename)) {
+        return;
+    }
+    // the platform cannot replace the file: write it again, the pieces are already compressed
+    FILE *fp = file_open(background_save.filename, "wb");
+    if (!fp) {
+        log_error("Unable to save game", 0, 0);
+        return;
+    }
+    savegame_write_to_file(fp, background_save.pieces, background_save.num_pieces);
+    file_close(fp);
+    file_remove(background_save.temp_filename);
+}
+
 int game_file_io_delete_saved_game(const char *filename)
 {
+    game_file_io_finish_background_save(1);
     log_info("Deleting game", filename, 0);
     int result = file_remove(filename);
     if (!result) {
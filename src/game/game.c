@@ -14,6 +14,7 @@
 #include "game/animation.h"
 #include "game/file.h"
 #include "game/file_editor.h"
+#include "game/profiler.h"
 #include "game/settings.h"
 #include "game/speed.h"
 #include "game/state.h"
@@ -169,8 +170,10 @@ int game_reload_language(void)
 
 void game_run(void)
 {
+    game_file_finish_background_save(0);
     game_animation_update();
     int num_ticks = game_speed_get_elapsed_ticks();
+    game_profiler_begin_frame();
     for (int i = 0; i < num_ticks; i++) {
         game_tick_run();
         game_file_write_mission_saved_game();
@@ -179,6 +182,7 @@ void game_run(void)
             break;
         }
     }
+    game_profiler_end_frame();
 }
 
 void game_draw(void)
@@ -189,6 +193,7 @@ void game_draw(void)
 
 void game_exit(void)
 {
+    game_file_finish_background_save(1);
     video_shutdown();
     settings_save();
     config_save();
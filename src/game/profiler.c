@@ -0,0 +1,258 @@
+#include "profiler.h"
+
+#include "core/file.h"
+#include "game/system.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define RING_SIZE 16384
+#define FIGURE_TYPE_NAME_LENGTH 24
+
+typedef struct {
+    unsigned int tick;
+    const char *name;
+    uint32_t duration_us;
+} ring_event;
+
+typedef struct {
+    const char *name;
+    uint64_t total_us;
+} frame_section;
+
+static struct {
+    int enabled;
+    unsigned int tick_id;
+    uint64_t tick_start;
+    profiler_section tick_slots[PROFILER_MAX_TICK_SLOTS];
+    profiler_section calls[PROFILER_MAX_SECTIONS];
+    int num_calls;
+    profiler_section figure_types[PROFILER_MAX_FIGURE_TYPES];
+    uint64_t figure_tick_us[PROFILER_MAX_FIGURE_TYPES];
+    char figure_type_names[PROFILER_MAX_FIGURE_TYPES][FIGURE_TYPE_NAME_LENGTH];
+    struct {
+        ring_event events[RING_SIZE];
+        int next;
+        int count;
+    } ring;
+    struct {
+        frame_section sections[PROFILER_MAX_SECTIONS];
+        int num_sections;
+        profiler_frame_summary current;
+        profiler_frame_summary last;
+    } frame;
+} data;
+
+static uint64_t record(profiler_section *section, const char *name, uint64_t start)
+{
+    uint64_t duration = system_get_micros() - start;
+    section->name = name;
+    section->calls++;
+    section->total_us += duration;
+    if (duration > section->max_us) {
+        section->max_us = duration;
+    }
+    return duration;
+}
+
+static void add_to_ring(const char *name, uint64_t duration)
+{
+    ring_event *event = &data.ring.events[data.ring.next];
+    event->tick = data.tick_id;
+    event->name = name;
+    event->duration_us = duration > UINT32_MAX ? UINT32_MAX : (uint32_t) duration;
+    data.ring.next = (data.ring.next + 1) % RING_SIZE;
+    if (data.ring.count < RING_SIZE) {
+        data.ring.count++;
+    }
+}
+
+static void add_to_frame(const char *name, uint64_t duration)
+{
+    frame_section *section = 0;
+    for (int i = 0; i < data.frame.num_sections; i++) {
+        if (data.frame.sections[i].name == name) {
+            section = &data.frame.sections[i];
+            break;
+        }
+    }
+    if (!section) {
+        if (data.frame.num_sections >= PROFILER_MAX_SECTIONS) {
+            return;
+        }
+        section = &data.frame.sections[data.frame.num_sections++];
+        section->name = name;
+        section->total_us = 0;
+    }
+    section->total_us += duration;
+    if (section->total_us > data.frame.current.heaviest_us) {
+        data.frame.current.heaviest_us = section->total_us;
+        data.frame.current.heaviest_name = name;
+    }
+}
+
+static void add_event(const char *name, uint64_t duration)
+{
+    if (duration) {
+        add_to_ring(name, duration);
+    }
+    add_to_frame(name, duration);
+}
+
+static profiler_section *get_call_section(const char *name)
+{
+    for (int i = 0; i < data.num_calls; i++) {
+        if (data.calls[i].name == name || strcmp(data.calls[i].name, name) == 0) {
+            return &data.calls[i];
+        }
+    }
+    if (data.num_calls >= PROFILER_MAX_SECTIONS) {
+        return 0;
+    }
+    return &data.calls[data.num_calls++];
+}
+
+static const char *get_figure_type_name(int figure_type)
+{
+    char *name = data.figure_type_names[figure_type];
+    if (!*name) {
+        snprintf(name, FIGURE_TYPE_NAME_LENGTH, "figure type %d", figure_type);
+    }
+    return name;
+}
+
+void game_profiler_set_enabled(int enabled)
+{
+    data.enabled = enabled;
+}
+
+int game_profiler_is_enabled(void)
+{
+    return data.enabled;
+}
+
+void game_profiler_reset(void)
+{
+    memset(data.tick_slots, 0, sizeof(data.tick_slots));
+    memset(data.calls, 0, sizeof(data.calls));
+    data.num_calls = 0;
+    memset(data.figure_types, 0, sizeof(data.figure_types));
+    memset(data.figure_tick_us, 0, sizeof(data.figure_tick_us));
+    data.ring.next = 0;
+    data.ring.count = 0;
+    data.tick_id = 0;
+    data.tick_start = 0;
+    data.frame.num_sections = 0;
+    memset(&data.frame.current, 0, sizeof(profiler_frame_summary));
+    memset(&data.frame.last, 0, sizeof(profiler_frame_summary));
+}
+
+uint64_t game_profiler_start(void)
+{
+    return data.enabled ? system_get_micros() : 0;
+}
+
+void game_profiler_record_tick_slot(int slot, const char *name, uint64_t start)
+{
+    if (!data.enabled || !start || slot < 0 || slot >= PROFILER_MAX_TICK_SLOTS) {
+        return;
+    }
+    add_event(name, record(&data.tick_slots[slot], name, start));
+}
+
+void game_profiler_record_call(const char *name, uint64_t start)
+{
+    if (!data.enabled || !start) {
+        return;
+    }
+    profiler_section *section = get_call_section(name);
+    if (section) {
+        add_event(name, record(section, name, start));
+    }
+}
+
+void game_profiler_record_figure(int figure_type, uint64_t start)
+{
+    if (!data.enabled || !start || figure_type < 0 || figure_type >= PROFILER_MAX_FIGURE_TYPES) {
+        return;
+    }
+    // figure actions are part of figure_action_handle(), so they are
+    // only added to the ring buffer at the end of the tick and not to the frame
+    data.figure_tick_us[figure_type] +=
+        record(&data.figure_types[figure_type], get_figure_type_name(figure_type), start);
+}
+
+void game_profiler_begin_tick(void)
+{
+    if (!data.enabled) {
+        return;
+    }
+    data.tick_id++;
+    data.tick_start = system_get_micros();
+}
+
+void game_profiler_end_tick(void)
+{
+    if (!data.enabled || !data.tick_start) {
+        return;
+    }
+    uint64_t duration = system_get_micros() - data.tick_start;
+    data.tick_start = 0;
+    for (int i = 0; i < PROFILER_MAX_FIGURE_TYPES; i++) {
+        if (data.figure_tick_us[i]) {
+            add_to_ring(get_figure_type_name(i), data.figure_tick_us[i]);
+            data.figure_tick_us[i] = 0;
+        }
+    }
+    add_to_ring("tick", duration);
+    data.frame.current.ticks++;
+    data.frame.current.total_us += duration;
+}
+
+void game_profiler_begin_frame(void)
+{
+    data.frame.num_sections = 0;
+    memset(&data.frame.current, 0, sizeof(profiler_frame_summary));
+}
+
+void game_profiler_end_frame(void)
+{
+    data.frame.last = data.frame.current;
+}
+
+const profiler_frame_summary *game_profiler_get_last_frame(void)
+{
+    return &data.frame.last;
+}
+
+const profiler_section *game_profiler_get_tick_slot(int slot)
+{
+    return &data.tick_slots[slot];
+}
+
+const profiler_section *game_profiler_get_call(int index)
+{
+    return index >= 0 && index < data.num_calls ? &data.calls[index] : 0;
+}
+
+const profiler_section *game_profiler_get_figure_type(int figure_type)
+{
+    return &data.figure_types[figure_type];
+}
+
+int game_profiler_write_csv(const char *filename)
+{
+    FILE *fp = file_open(filename, "w");
+    if (!fp) {
+        return 0;
+    }
+    fprintf(fp, "tick,section,microseconds\n");
+    int index = (data.ring.next - data.ring.count + RING_SIZE) % RING_SIZE;
+    for (int i = 0; i < data.ring.count; i++) {
+        const ring_event *event = &data.ring.events[index];
+        fprintf(fp, "%u,\"%s\",%u\n", event->tick, event->name, (unsigned int) event->duration_us);
+        index = (index + 1) % RING_SIZE;
+    }
+    file_close(fp);
+    return 1;
+}
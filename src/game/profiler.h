@@ -0,0 +1,156 @@
+#ifndef GAME_PROFILER_H
+#define GAME_PROFILER_H
+
+#include <stdint.h>
+
+/**
+ * @file
+ * Simulation profiler: measures how much time each part of a game tick takes.
+ * Profiling is disabled by default, in which case it costs only a flag check.
+ *
+ * Besides cumulative statistics per section, the profiler keeps a ring buffer
+ * of the most recent timings, which can be summarized per frame or dumped to CSV.
+ */
+
+#define PROFILER_MAX_TICK_SLOTS 50
+#define PROFILER_MAX_SECTIONS 64
+#define PROFILER_MAX_FIGURE_TYPES 80
+
+typedef struct {
+    const char *name;
+    unsigned int calls;
+    uint64_t total_us;
+    uint64_t max_us;
+} profiler_section;
+
+typedef struct {
+    int ticks;
+    uint64_t total_us;
+    const char *heaviest_name;
+    uint64_t heaviest_us;
+} profiler_frame_summary;
+
+/**
+ * Runs the statement that belongs to a tick slot and records its duration
+ * @param slot Tick slot, 0-49
+ * @param statement Statement to run, its text is used as section name
+ */
+#define PROFILE_TICK_SLOT(slot, statement) \
+    do { \
+        uint64_t profile_start = game_profiler_start(); \
+        statement; \
+        game_profiler_record_tick_slot(slot, #statement, profile_start); \
+    } while (0)
+
+/**
+ * Runs the statement and records its duration in a section named after the statement
+ * @param statement Statement to run
+ */
+#define PROFILE_CALL(statement) \
+    do { \
+        uint64_t profile_start = game_profiler_start(); \
+        statement; \
+        game_profiler_record_call(#statement, profile_start); \
+    } while (0)
+
+/**
+ * Enables or disables profiling
+ * @param enabled Whether to enable profiling
+ */
+void game_profiler_set_enabled(int enabled);
+
+/**
+ * Checks whether profiling is enabled
+ * @return True if enabled
+ */
+int game_profiler_is_enabled(void);
+
+/**
+ * Clears all recorded statistics and the ring buffer
+ */
+void game_profiler_reset(void);
+
+/**
+ * Starts measuring a section
+ * @return Start time to pass to the record function, 0 if profiling is disabled
+ */
+uint64_t game_profiler_start(void);
+
+/**
+ * Records the time spent in a tick slot since the start time
+ * @param slot Tick slot
+ * @param name Name of the code that was run in the slot
+ * @param start Start time as returned by game_profiler_start()
+ */
+void game_profiler_record_tick_slot(int slot, const char *name, uint64_t start);
+
+/**
+ * Records the time spent in a named call since the start time
+ * @param name Name of the call, must be a string that stays valid
+ * @param start Start time as returned by game_profiler_start()
+ */
+void game_profiler_record_call(const char *name, uint64_t start);
+
+/**
+ * Records the time spent in the action of a single figure since the start time
+ * @param figure_type Type of the figure
+ * @param start Start time as returned by game_profiler_start()
+ */
+void game_profiler_record_figure(int figure_type, uint64_t start);
+
+/**
+ * Marks the start of a game tick
+ */
+void game_profiler_begin_tick(void);
+
+/**
+ * Marks the end of a game tick, storing its timings in the ring buffer
+ */
+void game_profiler_end_tick(void);
+
+/**
+ * Marks the start of a frame, which may run any number of ticks
+ */
+void game_profiler_begin_frame(void);
+
+/**
+ * Marks the end of a frame
+ */
+void game_profiler_end_frame(void);
+
+/**
+ * Gets a summary of the ticks run in the last frame
+ * @return Frame summary, heaviest_name is 0 if no ticks were run
+ */
+const profiler_frame_summary *game_profiler_get_last_frame(void);
+
+/**
+ * Gets the statistics for a tick slot
+ * @param slot Tick slot
+ * @return Statistics, name is 0 if the slot has never been recorded
+ */
+const profiler_section *game_profiler_get_tick_slot(int slot);
+
+/**
+ * Gets the statistics for a named call, in order of first recording
+ * @param index Index of the call
+ * @return Statistics, or 0 if there is no call with that index
+ */
+const profiler_section *game_profiler_get_call(int index);
+
+/**
+ * Gets the statistics for the actions of a figure type
+ * @param figure_type Figure type
+ * @return Statistics, name is 0 if no figure of that type has been recorded
+ */
+const profiler_section *game_profiler_get_figure_type(int figure_type);
+
+/**
+ * Writes the contents of the ring buffer to a CSV file,
+ * with one line per recorded section: tick, section, microseconds
+ * @param filename File to write to
+ * @return True on success
+ */
+int game_profiler_write_csv(const char *filename);
+
+#endif // GAME_PROFILER_H
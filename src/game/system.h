@@ -4,6 +4,8 @@
 #include "graphics/color.h"
 #include "input/keys.h"
 
+#include <stdint.h>
+
 /**
  * @file
  * Functions that should implemented by the underlying system
@@ -152,6 +154,43 @@ void system_set_mouse_position(int *x, int *y);
  */
 color_t *system_create_framebuffer(int width, int height);
 
+/**
+ * Gets a high-resolution timestamp, meant for measuring short durations
+ * @return Time in microseconds since an arbitrary starting point
+ */
+uint64_t system_get_micros(void);
+
+typedef void (*system_task_func)(void *data, int index);
+
+/**
+ * Runs a task once for every index from 0 to count - 1, spread over the available processors.
+ * Returns when all of them have finished. Must not be called from within a task.
+ * @param task Task to run, must be safe to run at the same time for different indexes
+ * @param data Data to pass to the task
+ * @param count Number of times to run the task
+ */
+void system_run_parallel(system_task_func task, void *data, int count);
+
+/**
+ * Starts a task on a background thread. Only one background task can run at a time:
+ * if the previous one is still running, this waits for it to finish first.
+ * When no thread can be started, the task is run before this function returns.
+ * @param task Task to run
+ * @param data Data to pass to the task
+ */
+void system_run_in_background(void (*task)(void *data), void *data);
+
+/**
+ * Checks whether the background task is still running
+ * @return True if the task is running, false if it has finished or none was started
+ */
+int system_background_task_running(void);
+
+/**
+ * Waits until the background task has finished
+ */
+void system_wait_for_background_task(void);
+
 /**
  * Exit the game
  */
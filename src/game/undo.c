@@ -209,6 +209,7 @@ void game_undo_perform(void)
             if (data.buildings[i].id) {
                 building *b = building_get(data.buildings[i].id);
                 memcpy(b, &data.buildings[i], sizeof(building));
+                building_update_type_index(b);
                 if (b->type == BUILDING_WAREHOUSE || b->type == BUILDING_GRANARY) {
                     if (!building_storage_restore(b->storage_id)) {
                         building_storage_reset_building_ids();
@@ -0,0 +1,620 @@
+#include "blit.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLIT_HAS_SSE2
+#include <emmintrin.h>
+#if !defined(__EMSCRIPTEN__) && (defined(__GNUC__) || defined(_MSC_VER))
+#define BLIT_HAS_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define BLIT_HAS_NEON
+#include <arm_neon.h>
+#endif
+
+typedef struct {
+    void (*masked_copy)(color_t *dst, const color_t *src, int count);
+    void (*masked_set)(color_t *dst, const color_t *src, int count, color_t color);
+    void (*masked_and)(color_t *dst, const color_t *src, int count, color_t color);
+    void (*masked_blend)(color_t *dst, const color_t *src, int count, color_t color);
+    void (*and)(color_t *dst, const color_t *src, int count, color_t color);
+    void (*mix)(color_t *dst, int count, color_t color);
+    void (*convert_555)(color_t *dst, const uint8_t *src, int count);
+} blit_kernels;
+
+static void masked_copy_scalar(color_t *dst, const color_t *src, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (src[i] != COLOR_SG2_TRANSPARENT) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+static void masked_set_scalar(color_t *dst, const color_t *src, int count, color_t color)
+{
+    for (int i = 0; i < count; i++) {
+        if (src[i] != COLOR_SG2_TRANSPARENT) {
+            dst[i] = color;
+        }
+    }
+}
+
+static void masked_and_scalar(color_t *dst, const color_t *src, int count, color_t color)
+{
+    for (int i = 0; i < count; i++) {
+        if (src[i] != COLOR_SG2_TRANSPARENT) {
+            dst[i] = src[i] & color;
+        }
+    }
+}
+
+static void masked_blend_scalar(color_t *dst, const color_t *src, int count, color_t color)
+{
+    for (int i = 0; i < count; i++) {
+        if (src[i] != COLOR_SG2_TRANSPARENT) {
+            dst[i] &= color;
+        }
+    }
+}
+
+static void and_scalar(color_t *dst, const color_t *src, int count, color_t color)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = src[i] & color;
+    }
+}
+
+static void mix_scalar(color_t *dst, int count, color_t color)
+{
+    color_t alpha = color >> 24;
+    color_t alpha_dst = 256 - alpha;
+    color_t src_rb = (color & 0xff00ff) * alpha;
+    color_t src_g = (color & 0x00ff00) * alpha;
+    for (int i = 0; i < count; i++) {
+        color_t d = dst[i];
+        dst[i] = (((src_rb + (d & 0xff00ff) * alpha_dst) & 0xff00ff00) |
+                  ((src_g  + (d & 0x00ff00) * alpha_dst) & 0x00ff0000)) >> 8;
+    }
+}
+
+static void convert_555_scalar(color_t *dst, const uint8_t *src, int count)
+{
+    for (int i = 0; i < count; i++) {
+        color_t c = src[2 * i] | (src[2 * i + 1] << 8);
+        dst[i] = ((c & 0x7c00) << 9) | ((c & 0x7000) << 4) |
+                 ((c & 0x3e0) << 6)  | ((c & 0x380) << 1) |
+                 ((c & 0x1f) << 3)   | ((c & 0x1c) >> 2);
+    }
+}
+
+static const blit_kernels scalar_kernels = {
+    masked_copy_scalar, masked_set_scalar, masked_and_scalar, masked_blend_scalar, and_scalar, mix_scalar,
+    convert_555_scalar
+};
+
+// The convert kernels widen the 16-bit pixels to 32-bit lanes and then do the same shifts as convert_555_scalar.
+// They load the 16-bit pixels as little endian, which all supported SIMD platforms are.
+
+// The mix kernels work on 16-bit channels: every channel becomes (src * alpha + dst * (256 - alpha)) >> 8,
+// which is what mix_scalar computes for the red, green and blue channels. Alpha always ends up zero.
+
+#ifdef BLIT_HAS_SSE2
+
+static __m128i select_sse2(__m128i keep_dst, __m128i dst, __m128i value)
+{
+    return _mm_or_si128(_mm_and_si128(keep_dst, dst), _mm_andnot_si128(keep_dst, value));
+}
+
+static void masked_copy_sse2(color_t *dst, const color_t *src, int count)
+{
+    const __m128i transparent = _mm_set1_epi32(COLOR_SG2_TRANSPARENT);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) &src[i]);
+        __m128i skip = _mm_cmpeq_epi32(s, transparent);
+        int mask = _mm_movemask_epi8(skip);
+        if (mask == 0xffff) {
+            continue;
+        }
+        if (mask) {
+            s = select_sse2(skip, _mm_loadu_si128((const __m128i *) &dst[i]), s);
+        }
+        _mm_storeu_si128((__m128i *) &dst[i], s);
+    }
+    masked_copy_scalar(&dst[i], &src[i], count - i);
+}
+
+static void masked_set_sse2(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const __m128i transparent = _mm_set1_epi32(COLOR_SG2_TRANSPARENT);
+    const __m128i value = _mm_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i skip = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) &src[i]), transparent);
+        int mask = _mm_movemask_epi8(skip);
+        if (mask == 0xffff) {
+            continue;
+        }
+        __m128i result = mask ? select_sse2(skip, _mm_loadu_si128((const __m128i *) &dst[i]), value) : value;
+        _mm_storeu_si128((__m128i *) &dst[i], result);
+    }
+    masked_set_scalar(&dst[i], &src[i], count - i, color);
+}
+
+static void masked_and_sse2(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const __m128i transparent = _mm_set1_epi32(COLOR_SG2_TRANSPARENT);
+    const __m128i and_mask = _mm_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) &src[i]);
+        __m128i skip = _mm_cmpeq_epi32(s, transparent);
+        int mask = _mm_movemask_epi8(skip);
+        if (mask == 0xffff) {
+            continue;
+        }
+        __m128i result = _mm_and_si128(s, and_mask);
+        if (mask) {
+            result = select_sse2(skip, _mm_loadu_si128((const __m128i *) &dst[i]), result);
+        }
+        _mm_storeu_si128((__m128i *) &dst[i], result);
+    }
+    masked_and_scalar(&dst[i], &src[i], count - i, color);
+}
+
+static void masked_blend_sse2(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const __m128i transparent = _mm_set1_epi32(COLOR_SG2_TRANSPARENT);
+    const __m128i and_mask = _mm_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i skip = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) &src[i]), transparent);
+        if (_mm_movemask_epi8(skip) == 0xffff) {
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i *) &dst[i]);
+        _mm_storeu_si128((__m128i *) &dst[i], select_sse2(skip, d, _mm_and_si128(d, and_mask)));
+    }
+    masked_blend_scalar(&dst[i], &src[i], count - i, color);
+}
+
+static void and_sse2(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const __m128i and_mask = _mm_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) &src[i]);
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_and_si128(s, and_mask));
+    }
+    and_scalar(&dst[i], &src[i], count - i, color);
+}
+
+static void mix_sse2(color_t *dst, int count, color_t color)
+{
+    short alpha = (short) (color >> 24);
+    short alpha_dst = 256 - alpha;
+    short src_r = (short) (((color >> 16) & 0xff) * alpha);
+    short src_g = (short) (((color >> 8) & 0xff) * alpha);
+    short src_b = (short) ((color & 0xff) * alpha);
+    const __m128i src_term = _mm_set_epi16(0, src_r, src_g, src_b, 0, src_r, src_g, src_b);
+    const __m128i dst_factor = _mm_set_epi16(0, alpha_dst, alpha_dst, alpha_dst, 0, alpha_dst, alpha_dst, alpha_dst);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *) &dst[i]);
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), dst_factor), src_term);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), dst_factor), src_term);
+        d = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+        _mm_storeu_si128((__m128i *) &dst[i], d);
+    }
+    mix_scalar(&dst[i], count - i, color);
+}
+
+static __m128i convert_555_lanes_sse2(__m128i c)
+{
+    __m128i r = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x7c00)), 9),
+        _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x7000)), 4));
+    __m128i g = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x3e0)), 6),
+        _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x380)), 1));
+    __m128i b = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x1f)), 3),
+        _mm_srli_epi32(_mm_and_si128(c, _mm_set1_epi32(0x1c)), 2));
+    return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+static void convert_555_sse2(color_t *dst, const uint8_t *src, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i *) &src[2 * i]);
+        _mm_storeu_si128((__m128i *) &dst[i], convert_555_lanes_sse2(_mm_unpacklo_epi16(c, zero)));
+        _mm_storeu_si128((__m128i *) &dst[i + 4], convert_555_lanes_sse2(_mm_unpackhi_epi16(c, zero)));
+    }
+    convert_555_scalar(&dst[i], &src[2 * i], count - i);
+}
+
+static const blit_kernels sse2_kernels = {
+    masked_copy_sse2, masked_set_sse2, masked_and_sse2, masked_blend_sse2, and_sse2, mix_sse2, convert_555_sse2
+};
+
+#endif // BLIT_HAS_SSE2
+
+#ifdef BLIT_HAS_AVX2
+
+TARGET_AVX2 static void masked_copy_avx2(color_t *dst, const color_t *src, int count)
+{
+    const __m256i transparent = _mm256_set1_epi32(COLOR_SG2_TRANSPARENT);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) &src[i]);
+        __m256i skip = _mm256_cmpeq_epi32(s, transparent);
+        int mask = _mm256_movemask_epi8(skip);
+        if (mask == -1) {
+            continue;
+        }
+        if (mask) {
+            s = _mm256_blendv_epi8(s, _mm256_loadu_si256((const __m256i *) &dst[i]), skip);
+        }
+        _mm256_storeu_si256((__m256i *) &dst[i], s);
+    }
+    masked_copy_scalar(&dst[i], &src[i], count - i);
+}
+
+TARGET_AVX2 static void masked_set_avx2(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const __m256i transparent = _mm256_set1_epi32(COLOR_SG2_TRANSPARENT);
+    const __m256i value = _mm256_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i skip = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) &src[i]), transparent);
+        int mask = _mm256_movemask_epi8(skip);
+        if (mask == -1) {
+            continue;
+        }
+        __m256i result = mask ?
+            _mm256_blendv_epi8(value, _mm256_loadu_si256((const __m256i *) &dst[i]), skip) : value;
+        _mm256_storeu_si256((__m256i *) &dst[i], result);
+    }
+    masked_set_scalar(&dst[i], &src[i], count - i, color);
+}
+
+TARGET_AVX2 static void masked_and_avx2(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const __m256i transparent = _mm256_set1_epi32(COLOR_SG2_TRANSPARENT);
+    const __m256i and_mask = _mm256_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) &src[i]);
+        __m256i skip = _mm256_cmpeq_epi32(s, transparent);
+        int mask = _mm256_movemask_epi8(skip);
+        if (mask == -1) {
+            continue;
+        }
+        __m256i result = _mm256_and_si256(s, and_mask);
+        if (mask) {
+            result = _mm256_blendv_epi8(result, _mm256_loadu_si256((const __m256i *) &dst[i]), skip);
+        }
+        _mm256_storeu_si256((__m256i *) &dst[i], result);
+    }
+    masked_and_scalar(&dst[i], &src[i], count - i, color);
+}
+
+TARGET_AVX2 static void masked_blend_avx2(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const __m256i transparent = _mm256_set1_epi32(COLOR_SG2_TRANSPARENT);
+    const __m256i and_mask = _mm256_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i skip = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) &src[i]), transparent);
+        if (_mm256_movemask_epi8(skip) == -1) {
+            continue;
+        }
+        __m256i d = _mm256_loadu_si256((const __m256i *) &dst[i]);
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_blendv_epi8(_mm256_and_si256(d, and_mask), d, skip));
+    }
+    masked_blend_scalar(&dst[i], &src[i], count - i, color);
+}
+
+TARGET_AVX2 static void and_avx2(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const __m256i and_mask = _mm256_set1_epi32((int) color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) &src[i]);
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_and_si256(s, and_mask));
+    }
+    and_scalar(&dst[i], &src[i], count - i, color);
+}
+
+TARGET_AVX2 static void mix_avx2(color_t *dst, int count, color_t color)
+{
+    short alpha = (short) (color >> 24);
+    short alpha_dst = 256 - alpha;
+    short src_r = (short) (((color >> 16) & 0xff) * alpha);
+    short src_g = (short) (((color >> 8) & 0xff) * alpha);
+    short src_b = (short) ((color & 0xff) * alpha);
+    const __m256i src_term = _mm256_set_epi16(0, src_r, src_g, src_b, 0, src_r, src_g, src_b,
+        0, src_r, src_g, src_b, 0, src_r, src_g, src_b);
+    const __m256i dst_factor = _mm256_set_epi16(0, alpha_dst, alpha_dst, alpha_dst, 0, alpha_dst, alpha_dst, alpha_dst,
+        0, alpha_dst, alpha_dst, alpha_dst, 0, alpha_dst, alpha_dst, alpha_dst);
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // unpack and pack both work per 128-bit lane, so the pixels stay in order
+        __m256i d = _mm256_loadu_si256((const __m256i *) &dst[i]);
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), dst_factor), src_term);
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), dst_factor), src_term);
+        d = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+        _mm256_storeu_si256((__m256i *) &dst[i], d);
+    }
+    mix_scalar(&dst[i], count - i, color);
+}
+
+TARGET_AVX2 static __m256i convert_555_lanes_avx2(__m256i c)
+{
+    __m256i r = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x7c00)), 9),
+        _mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x7000)), 4));
+    __m256i g = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x3e0)), 6),
+        _mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x380)), 1));
+    __m256i b = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x1f)), 3),
+        _mm256_srli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0x1c)), 2));
+    return _mm256_or_si256(_mm256_or_si256(r, g), b);
+}
+
+TARGET_AVX2 static void convert_555_avx2(color_t *dst, const uint8_t *src, int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i c = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) &src[2 * i]));
+        _mm256_storeu_si256((__m256i *) &dst[i], convert_555_lanes_avx2(c));
+    }
+    convert_555_scalar(&dst[i], &src[2 * i], count - i);
+}
+
+static const blit_kernels avx2_kernels = {
+    masked_copy_avx2, masked_set_avx2, masked_and_avx2, masked_blend_avx2, and_avx2, mix_avx2, convert_555_avx2
+};
+
+static int cpu_has_avx2(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return 0;
+    }
+    __cpuid(info, 1);
+    int has_osxsave = (info[2] & (1 << 27)) != 0;
+    int has_avx = (info[2] & (1 << 28)) != 0;
+    // the OS has to save the AVX registers on context switches
+    if (!has_osxsave || !has_avx || (_xgetbv(0) & 6) != 6) {
+        return 0;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // BLIT_HAS_AVX2
+
+#ifdef BLIT_HAS_NEON
+
+static void masked_copy_neon(color_t *dst, const color_t *src, int count)
+{
+    const uint32x4_t transparent = vdupq_n_u32(COLOR_SG2_TRANSPARENT);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t s = vld1q_u32(&src[i]);
+        uint32x4_t skip = vceqq_u32(s, transparent);
+        vst1q_u32(&dst[i], vbslq_u32(skip, vld1q_u32(&dst[i]), s));
+    }
+    masked_copy_scalar(&dst[i], &src[i], count - i);
+}
+
+static void masked_set_neon(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const uint32x4_t transparent = vdupq_n_u32(COLOR_SG2_TRANSPARENT);
+    const uint32x4_t value = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t skip = vceqq_u32(vld1q_u32(&src[i]), transparent);
+        vst1q_u32(&dst[i], vbslq_u32(skip, vld1q_u32(&dst[i]), value));
+    }
+    masked_set_scalar(&dst[i], &src[i], count - i, color);
+}
+
+static void masked_and_neon(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const uint32x4_t transparent = vdupq_n_u32(COLOR_SG2_TRANSPARENT);
+    const uint32x4_t and_mask = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t s = vld1q_u32(&src[i]);
+        uint32x4_t skip = vceqq_u32(s, transparent);
+        vst1q_u32(&dst[i], vbslq_u32(skip, vld1q_u32(&dst[i]), vandq_u32(s, and_mask)));
+    }
+    masked_and_scalar(&dst[i], &src[i], count - i, color);
+}
+
+static void masked_blend_neon(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const uint32x4_t transparent = vdupq_n_u32(COLOR_SG2_TRANSPARENT);
+    const uint32x4_t and_mask = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t skip = vceqq_u32(vld1q_u32(&src[i]), transparent);
+        uint32x4_t d = vld1q_u32(&dst[i]);
+        vst1q_u32(&dst[i], vbslq_u32(skip, d, vandq_u32(d, and_mask)));
+    }
+    masked_blend_scalar(&dst[i], &src[i], count - i, color);
+}
+
+static void and_neon(color_t *dst, const color_t *src, int count, color_t color)
+{
+    const uint32x4_t and_mask = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u32(&dst[i], vandq_u32(vld1q_u32(&src[i]), and_mask));
+    }
+    and_scalar(&dst[i], &src[i], count - i, color);
+}
+
+static void mix_neon(color_t *dst, int count, color_t color)
+{
+    uint8_t alpha = (uint8_t) (color >> 24);
+    uint8_t alpha_dst = (uint8_t) (256 - alpha);
+    uint16_t src_r = (uint16_t) (((color >> 16) & 0xff) * alpha);
+    uint16_t src_g = (uint16_t) (((color >> 8) & 0xff) * alpha);
+    uint16_t src_b = (uint16_t) ((color & 0xff) * alpha);
+    const uint8_t factors[8] = {alpha_dst, alpha_dst, alpha_dst, 0, alpha_dst, alpha_dst, alpha_dst, 0};
+    const uint16_t terms[8] = {src_b, src_g, src_r, 0, src_b, src_g, src_r, 0};
+    const uint8x8_t dst_factor = vld1_u8(factors);
+    const uint16x8_t src_term = vld1q_u16(terms);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint8x16_t d = vreinterpretq_u8_u32(vld1q_u32(&dst[i]));
+        uint16x8_t lo = vmlal_u8(src_term, vget_low_u8(d), dst_factor);
+        uint16x8_t hi = vmlal_u8(src_term, vget_high_u8(d), dst_factor);
+        d = vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+        vst1q_u32(&dst[i], vreinterpretq_u32_u8(d));
+    }
+    mix_scalar(&dst[i], count - i, color);
+}
+
+static uint32x4_t convert_555_lanes_neon(uint32x4_t c)
+{
+    uint32x4_t r = vorrq_u32(vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x7c00)), 9),
+        vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x7000)), 4));
+    uint32x4_t g = vorrq_u32(vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x3e0)), 6),
+        vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x380)), 1));
+    uint32x4_t b = vorrq_u32(vshlq_n_u32(vandq_u32(c, vdupq_n_u32(0x1f)), 3),
+        vshrq_n_u32(vandq_u32(c, vdupq_n_u32(0x1c)), 2));
+    return vorrq_u32(vorrq_u32(r, g), b);
+}
+
+static void convert_555_neon(color_t *dst, const uint8_t *src, int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t c = vreinterpretq_u16_u8(vld1q_u8(&src[2 * i]));
+        vst1q_u32(&dst[i], convert_555_lanes_neon(vmovl_u16(vget_low_u16(c))));
+        vst1q_u32(&dst[i + 4], convert_555_lanes_neon(vmovl_u16(vget_high_u16(c))));
+    }
+    convert_555_scalar(&dst[i], &src[2 * i], count - i);
+}
+
+static const blit_kernels neon_kernels = {
+    masked_copy_neon, masked_set_neon, masked_and_neon, masked_blend_neon, and_neon, mix_neon, convert_555_neon
+};
+
+#endif // BLIT_HAS_NEON
+
+static const char *IMPLEMENTATION_NAMES[BLIT_MAX_IMPLEMENTATIONS] = {"scalar", "SSE2", "AVX2", "NEON"};
+
+static struct {
+    int initialized;
+    const blit_kernels *kernels;
+} data = {0, &scalar_kernels};
+
+static const blit_kernels *get_kernels(blit_implementation implementation)
+{
+    switch (implementation) {
+        case BLIT_SCALAR:
+            return &scalar_kernels;
+#ifdef BLIT_HAS_SSE2
+        case BLIT_SSE2:
+            return &sse2_kernels;
+#endif
+#ifdef BLIT_HAS_AVX2
+        case BLIT_AVX2:
+            return cpu_has_avx2() ? &avx2_kernels : 0;
+#endif
+#ifdef BLIT_HAS_NEON
+        case BLIT_NEON:
+            return &neon_kernels;
+#endif
+        default:
+            return 0;
+    }
+}
+
+void blit_init(void)
+{
+    if (data.initialized) {
+        return;
+    }
+    data.initialized = 1;
+    for (int i = BLIT_MAX_IMPLEMENTATIONS - 1; i >= 0; i--) {
+        if (blit_set_implementation(i)) {
+            return;
+        }
+    }
+}
+
+int blit_is_supported(blit_implementation implementation)
+{
+    return get_kernels(implementation) != 0;
+}
+
+int blit_set_implementation(blit_implementation implementation)
+{
+    const blit_kernels *kernels = get_kernels(implementation);
+    if (!kernels) {
+        return 0;
+    }
+    data.kernels = kernels;
+    return 1;
+}
+
+const char *blit_implementation_name(blit_implementation implementation)
+{
+    return implementation >= 0 && implementation < BLIT_MAX_IMPLEMENTATIONS ?
+        IMPLEMENTATION_NAMES[implementation] : "unknown";
+}
+
+void blit_masked_copy(color_t *dst, const color_t *src, int count)
+{
+    data.kernels->masked_copy(dst, src, count);
+}
+
+void blit_masked_set(color_t *dst, const color_t *src, int count, color_t color)
+{
+    data.kernels->masked_set(dst, src, count, color);
+}
+
+void blit_masked_and(color_t *dst, const color_t *src, int count, color_t color)
+{
+    data.kernels->masked_and(dst, src, count, color);
+}
+
+void blit_masked_blend(color_t *dst, const color_t *src, int count, color_t color)
+{
+    data.kernels->masked_blend(dst, src, count, color);
+}
+
+void blit_and(color_t *dst, const color_t *src, int count, color_t color)
+{
+    data.kernels->and(dst, src, count, color);
+}
+
+void blit_mix(color_t *dst, int count, color_t color)
+{
+    data.kernels->mix(dst, count, color);
+}
+
+void blit_convert_555(color_t *dst, const uint8_t *src, int count)
+{
+    data.kernels->convert_555(dst, src, count);
+}
@@ -0,0 +1,90 @@
+#ifndef GRAPHICS_BLIT_H
+#define GRAPHICS_BLIT_H
+
+#include "graphics/color.h"
+
+/**
+ * @file
+ * Pixel row kernels for drawing images.
+ *
+ * Every kernel has a scalar version and SIMD versions for the instruction sets
+ * the CPU supports. All versions produce exactly the same pixels.
+ * The masked kernels leave the destination alone where the source pixel is COLOR_SG2_TRANSPARENT.
+ */
+
+typedef enum {
+    BLIT_SCALAR = 0,
+    BLIT_SSE2 = 1,
+    BLIT_AVX2 = 2,
+    BLIT_NEON = 3,
+    BLIT_MAX_IMPLEMENTATIONS = 4
+} blit_implementation;
+
+/**
+ * Selects the fastest implementation the CPU supports
+ */
+void blit_init(void);
+
+/**
+ * Checks whether an implementation can be used on this CPU
+ * @param implementation Implementation to check
+ * @return True if the implementation is supported
+ */
+int blit_is_supported(blit_implementation implementation);
+
+/**
+ * Switches to another implementation
+ * @param implementation Implementation to use
+ * @return True if switched, false if the implementation is not supported
+ */
+int blit_set_implementation(blit_implementation implementation);
+
+/**
+ * Gets the name of an implementation
+ * @param implementation Implementation
+ * @return Name of the implementation
+ */
+const char *blit_implementation_name(blit_implementation implementation);
+
+/**
+ * Copies the non-transparent source pixels
+ */
+void blit_masked_copy(color_t *dst, const color_t *src, int count);
+
+/**
+ * Sets the destination to the color where the source is not transparent
+ */
+void blit_masked_set(color_t *dst, const color_t *src, int count, color_t color);
+
+/**
+ * Copies the non-transparent source pixels ANDed with the color
+ */
+void blit_masked_and(color_t *dst, const color_t *src, int count, color_t color);
+
+/**
+ * ANDs the destination with the color where the source is not transparent
+ */
+void blit_masked_blend(color_t *dst, const color_t *src, int count, color_t color);
+
+/**
+ * Copies the source pixels ANDed with the color
+ */
+void blit_and(color_t *dst, const color_t *src, int count, color_t color);
+
+/**
+ * Mixes the color into the destination using the alpha of the color
+ * @param dst Destination pixels
+ * @param count Number of pixels
+ * @param color Color to mix in, its alpha must be between 1 and 254
+ */
+void blit_mix(color_t *dst, int count, color_t color);
+
+/**
+ * Converts 16-bit 555 pixels, as stored in the game files, to 32-bit pixels
+ * @param dst Destination pixels
+ * @param src Source pixels, two little endian bytes each, need not be aligned
+ * @param count Number of pixels
+ */
+void blit_convert_555(color_t *dst, const uint8_t *src, int count);
+
+#endif // GRAPHICS_BLIT_H
@@ -1,18 +1,28 @@
 #include "graphics.h"
 
 #include "game/system.h"
+#include "graphics/blit.h"
 #include "graphics/screen.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+#define MAX_DIRTY_RECTS 32
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 static struct {
     color_t *pixels;
     int width;
     int height;
 } canvas;
 
-static struct {
+// The clip state is kept per thread, so parts of the screen can be drawn on several threads at once
+static THREAD_LOCAL struct {
     int x_start;
     int x_end;
     int y_start;
@@ -24,7 +34,14 @@ static struct {
     int y;
 } translation;
 
-static clip_info clip;
+static THREAD_LOCAL clip_info clip;
+
+static struct {
+    graphics_dirty_rect rects[MAX_DIRTY_RECTS];
+    int num_rects;
+    int last_index;
+    int disabled;
+} dirty;
 
 void graphics_init_canvas(int width, int height)
 {
@@ -34,6 +51,8 @@ void graphics_init_canvas(int width, int height)
     canvas.height = height;
 
     graphics_set_clip_rectangle(0, 0, width, height);
+    graphics_mark_all_dirty();
+    blit_init();
 }
 
 const void *graphics_canvas(void)
@@ -41,6 +60,113 @@ const void *graphics_canvas(void)
     return canvas.pixels;
 }
 
+static int rect_area(const graphics_dirty_rect *rect)
+{
+    return (rect->x_end - rect->x_start) * (rect->y_end - rect->y_start);
+}
+
+static int contains_rect(const graphics_dirty_rect *outer, const graphics_dirty_rect *inner)
+{
+    return outer->x_start <= inner->x_start && outer->x_end >= inner->x_end &&
+        outer->y_start <= inner->y_start && outer->y_end >= inner->y_end;
+}
+
+static graphics_dirty_rect union_rect(const graphics_dirty_rect *a, const graphics_dirty_rect *b)
+{
+    graphics_dirty_rect result = {
+        a->x_start < b->x_start ? a->x_start : b->x_start,
+        a->y_start < b->y_start ? a->y_start : b->y_start,
+        a->x_end > b->x_end ? a->x_end : b->x_end,
+        a->y_end > b->y_end ? a->y_end : b->y_end
+    };
+    return result;
+}
+
+static void add_dirty_rect(graphics_dirty_rect rect)
+{
+    if (rect.x_start < 0) {
+        rect.x_start = 0;
+    }
+    if (rect.y_start < 0) {
+        rect.y_start = 0;
+    }
+    if (rect.x_end > canvas.width) {
+        rect.x_end = canvas.width;
+    }
+    if (rect.y_end > canvas.height) {
+        rect.y_end = canvas.height;
+    }
+    if (rect.x_start >= rect.x_end || rect.y_start >= rect.y_end) {
+        return;
+    }
+    // consecutive draws tend to hit the same region, so check the last rectangle first
+    if (dirty.num_rects && contains_rect(&dirty.rects[dirty.last_index], &rect)) {
+        return;
+    }
+    int best_index = 0;
+    int best_growth = 0;
+    for (int i = 0; i < dirty.num_rects; i++) {
+        graphics_dirty_rect merged = union_rect(&dirty.rects[i], &rect);
+        int growth = rect_area(&merged) - rect_area(&dirty.rects[i]) - rect_area(&rect);
+        if (growth <= 0) {
+            // merging does not cover any pixels that were not dirty already
+            dirty.rects[i] = merged;
+            dirty.last_index = i;
+            return;
+        }
+        if (i == 0 || growth < best_growth) {
+            best_index = i;
+            best_growth = growth;
+        }
+    }
+    if (dirty.num_rects < MAX_DIRTY_RECTS) {
+        dirty.last_index = dirty.num_rects++;
+        dirty.rects[dirty.last_index] = rect;
+    } else {
+        dirty.rects[best_index] = union_rect(&dirty.rects[best_index], &rect);
+        dirty.last_index = best_index;
+    }
+}
+
+void graphics_mark_dirty(int x, int y, int width, int height)
+{
+    if (dirty.disabled) {
+        return;
+    }
+    graphics_dirty_rect rect = {
+        translation.x + x, translation.y + y,
+        translation.x + x + width, translation.y + y + height
+    };
+    add_dirty_rect(rect);
+}
+
+void graphics_mark_all_dirty(void)
+{
+    dirty.rects[0].x_start = 0;
+    dirty.rects[0].y_start = 0;
+    dirty.rects[0].x_end = canvas.width;
+    dirty.rects[0].y_end = canvas.height;
+    dirty.num_rects = 1;
+    dirty.last_index = 0;
+}
+
+const graphics_dirty_rect *graphics_get_dirty_rects(int *num_rects)
+{
+    *num_rects = dirty.num_rects;
+    return dirty.rects;
+}
+
+void graphics_set_dirty_tracking(int enabled)
+{
+    dirty.disabled = !enabled;
+}
+
+void graphics_clear_dirty_rects(void)
+{
+    dirty.num_rects = 0;
+    dirty.last_index = 0;
+}
+
 static void translate_clip(int dx, int dy)
 {
     clip_rectangle.x_start -= dx;
@@ -153,7 +279,7 @@ static void set_clip_y(int y_offset, int height)
     clip.visible_pixels_y = height - clip.clipped_pixels_top - clip.clipped_pixels_bottom;
 }
 
-const clip_info *graphics_get_clip_info(int x, int y, int width, int height)
+static const clip_info *calculate_clip(int x, int y, int width, int height)
 {
     set_clip_x(x, width);
     set_clip_y(y, height);
@@ -165,9 +291,20 @@ const clip_info *graphics_get_clip_info(int x, int y, int width, int height)
     return &clip;
 }
 
+const clip_info *graphics_get_clip_info(int x, int y, int width, int height)
+{
+    // the clip info is requested right before drawing, so the visible part is about to change
+    calculate_clip(x, y, width, height);
+    if (clip.is_visible) {
+        graphics_mark_dirty(x + clip.clipped_pixels_left, y + clip.clipped_pixels_top,
+            clip.visible_pixels_x, clip.visible_pixels_y);
+    }
+    return &clip;
+}
+
 void graphics_save_to_buffer(int x, int y, int width, int height, color_t *buffer)
 {
-    const clip_info *current_clip = graphics_get_clip_info(x, y, width, height);
+    const clip_info *current_clip = calculate_clip(x, y, width, height);
     if (!current_clip->is_visible) {
         return;
     }
@@ -203,6 +340,7 @@ color_t *graphics_get_pixel(int x, int y)
 void graphics_clear_screen(void)
 {
     memset(canvas.pixels, 0, sizeof(color_t) * canvas.width * canvas.height);
+    graphics_mark_all_dirty();
 }
 
 void graphics_draw_vertical_line(int x, int y1, int y2, color_t color)
@@ -214,6 +352,7 @@ void graphics_draw_vertical_line(int x, int y1, int y2, color_t color)
     int y_max = y1 < y2 ? y2 : y1;
     y_min = y_min < clip_rectangle.y_start ? clip_rectangle.y_start : y_min;
     y_max = y_max >= clip_rectangle.y_end ? clip_rectangle.y_end - 1 : y_max;
+    graphics_mark_dirty(x, y_min, 1, y_max - y_min + 1);
     color_t *pixel = graphics_get_pixel(x, y_min);
     color_t *end_pixel = pixel + ((y_max - y_min) * canvas.width);
     while (pixel <= end_pixel) {
@@ -231,6 +370,7 @@ void graphics_draw_horizontal_line(int x1, int x2, int y, color_t color)
     int x_max = x1 < x2 ? x2 : x1;
     x_min = x_min < clip_rectangle.x_start ? clip_rectangle.x_start : x_min;
     x_max = x_max >= clip_rectangle.x_end ? clip_rectangle.x_end - 1 : x_max;
+    graphics_mark_dirty(x_min, y, x_max - x_min + 1, 1);
     color_t *pixel = graphics_get_pixel(x_min, y);
     color_t *end_pixel = pixel + (x_max - x_min);
     while (pixel <= end_pixel) {
@@ -25,9 +25,24 @@ typedef struct {
     int is_visible;
 } clip_info;
 
+typedef struct {
+    int x_start;
+    int y_start;
+    int x_end;
+    int y_end;
+} graphics_dirty_rect;
+
 void graphics_init_canvas(int width, int height);
 const void *graphics_canvas(void);
 
+// Tracking of the canvas regions that changed since the last call to graphics_clear_dirty_rects()
+void graphics_mark_dirty(int x, int y, int width, int height);
+void graphics_mark_all_dirty(void);
+const graphics_dirty_rect *graphics_get_dirty_rects(int *num_rects);
+void graphics_clear_dirty_rects(void);
+// Dirty tracking is not thread safe: disable it while drawing on several threads and mark the region beforehand
+void graphics_set_dirty_tracking(int enabled);
+
 void graphics_in_dialog(void);
 void graphics_reset_dialog(void);
 
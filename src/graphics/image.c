@@ -1,6 +1,7 @@
 #include "image.h"
 
 #include "core/log.h"
+#include "graphics/blit.h"
 #include "graphics/graphics.h"
 #include "graphics/screen.h"
 
@@ -43,40 +44,23 @@ static void draw_uncompressed(
         data += clip->clipped_pixels_left;
         color_t *dst = graphics_get_pixel(x_offset + clip->clipped_pixels_left, y_offset + y);
         int x_max = img->width - clip->clipped_pixels_right;
+        int num_pixels = x_max - clip->clipped_pixels_left;
         if (type == DRAW_TYPE_NONE) {
             if (img->draw.type == IMAGE_TYPE_WITH_TRANSPARENCY || img->draw.is_external) { // can be transparent
-                for (int x = clip->clipped_pixels_left; x < x_max; x++, dst++) {
-                    if (*data != COLOR_SG2_TRANSPARENT) {
-                        *dst = *data;
-                    }
-                    data++;
-                }
+                blit_masked_copy(dst, data, num_pixels);
             } else {
-                int num_pixels = x_max - clip->clipped_pixels_left;
                 memcpy(dst, data, num_pixels * sizeof(color_t));
-                data += num_pixels;
             }
+            data += num_pixels;
         } else if (type == DRAW_TYPE_SET) {
-            for (int x = clip->clipped_pixels_left; x < x_max; x++, dst++) {
-                if (*data != COLOR_SG2_TRANSPARENT) {
-                    *dst = color;
-                }
-                data++;
-            }
+            blit_masked_set(dst, data, num_pixels, color);
+            data += num_pixels;
         } else if (type == DRAW_TYPE_AND) {
-            for (int x = clip->clipped_pixels_left; x < x_max; x++, dst++) {
-                if (*data != COLOR_SG2_TRANSPARENT) {
-                    *dst = *data & color;
-                }
-                data++;
-            }
+            blit_masked_and(dst, data, num_pixels, color);
+            data += num_pixels;
         } else if (type == DRAW_TYPE_BLEND) {
-            for (int x = clip->clipped_pixels_left; x < x_max; x++, dst++) {
-                if (*data != COLOR_SG2_TRANSPARENT) {
-                    *dst &= color;
-                }
-                data++;
-            }
+            blit_masked_blend(dst, data, num_pixels, color);
+            data += num_pixels;
         } else if (type == DRAW_TYPE_BLEND_ALPHA) {
             for (int x = clip->clipped_pixels_left; x < x_max; x++, dst++) {
                 if (*data != COLOR_SG2_TRANSPARENT) {
@@ -214,12 +198,7 @@ static void draw_compressed_and(
                 color_t *dst = graphics_get_pixel(x_offset + x, y_offset + y);
                 if (unclipped) {
                     x += b;
-                    while (b) {
-                        *dst = *pixels & color;
-                        dst++;
-                        pixels++;
-                        b--;
-                    }
+                    blit_and(dst, pixels, b, color);
                 } else {
                     while (b) {
                         if (x >= clip->clipped_pixels_left && x < img->width - clip->clipped_pixels_right) {
@@ -321,13 +300,8 @@ static void draw_compressed_blend_alpha(
                 data += b;
                 if (unclipped) {
                     x += b;
-                    while (b) {
-                        color_t d = *dst;
-                        *dst = (((src_rb + (d & 0xff00ff) * alpha_dst) & 0xff00ff00) |
-                                ((src_g  + (d & 0x00ff00) * alpha_dst) & 0x00ff0000)) >> 8;
-                        b--;
-                        dst++;
-                    }
+                    blit_mix(dst, b, color);
+                    dst += b;
                 } else {
                     while (b) {
                         if (x >= clip->clipped_pixels_left && x < img->width - clip->clipped_pixels_right) {
@@ -433,10 +407,8 @@ static void draw_footprint_tile(const color_t *data, int x_offset, int y_offset,
             memcpy(buffer, src, x_max * sizeof(color_t));
             src += x_max + x_pixel_advance;
         } else {
-            for (int x = 0; x < x_max; x++, buffer++, src++) {
-                *buffer = *src & color_mask;
-            }
-            src += x_pixel_advance;
+            blit_and(buffer, src, x_max, color_mask);
+            src += x_max + x_pixel_advance;
         }
     }
 }
@@ -286,7 +286,10 @@ int text_draw(const uint8_t *str, int x, int y, font_t font, color_t color)
 
         str += num_bytes;
         length -= num_bytes;
-        input_cursor.position += num_bytes;
+        // only touch the cursor when capturing: text on the city map is drawn on several threads
+        if (input_cursor.capture) {
+            input_cursor.position += num_bytes;
+        }
     }
     if (input_cursor.capture && !input_cursor.seen) {
         input_cursor.width = 4;
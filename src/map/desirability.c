@@ -3,20 +3,80 @@
 #include "building/building.h"
 #include "building/model.h"
 #include "core/calc.h"
+#include "core/log.h"
 #include "map/data.h"
 #include "map/grid.h"
 #include "map/property.h"
 #include "map/ring.h"
 #include "map/terrain.h"
 
+#include <string.h>
+
+typedef struct {
+    int x;
+    int y;
+    int size;
+    int value;
+    int step;
+    int step_size;
+    int range;
+} desirability_source;
+
+enum {
+    TERRAIN_SOURCE_NONE = 0,
+    TERRAIN_SOURCE_PLAZA = 1,
+    TERRAIN_SOURCE_EARTHQUAKE = 2,
+    TERRAIN_SOURCE_GARDEN = 3,
+    TERRAIN_SOURCE_RUBBLE = 4
+};
+
 static grid_i8 desirability_grid;
 
+// The daily update keeps the positive and negative contributions of every tile up to date, and only
+// stamps the sources that changed since the previous day. The original update clamps after every
+// addition, and bounds the wrong tile near the map edge, but as long as the positive contributions
+// stay at most 100 and the negative ones at least -100, none of the clamping does anything and the
+// result is just the sum. When a tile goes beyond that, the full update is run instead.
+static struct {
+    int is_valid;
+    grid_i16 positive;
+    grid_i16 negative;
+    desirability_source buildings[MAX_BUILDINGS];
+    int highest_building_id;
+    grid_u8 terrain_sources;
+    int verify;
+    int verify_failures;
+    grid_i8 verify_grid;
+} incremental;
+
 void map_desirability_clear(void)
 {
     map_grid_clear_i8(desirability_grid.items);
+    incremental.is_valid = 0;
+}
+
+static int get_ring_values(const desirability_source *source, int *values)
+{
+    int num_rings = 0;
+    if (source->size > 0) {
+        int range = source->range;
+        if (range > 6) range = 6;
+        int desirability = source->value;
+        int tiles_within_step = 0;
+        while (range > 0) {
+            values[num_rings++] = desirability;
+            range--;
+            tiles_within_step++;
+            if (tiles_within_step >= source->step) {
+                desirability += source->step_size;
+                tiles_within_step = 0;
+            }
+        }
+    }
+    return num_rings;
 }
 
-static void add_desirability_at_distance(int x, int y, int size, int distance, int desirability)
+static int is_partially_outside_map(int x, int y, int size, int distance)
 {
     int partially_outside_map = 0;
     if (x - distance < -1 || x + distance + size - 1 > map_data.width) {
@@ -25,62 +85,183 @@ static void add_desirability_at_distance(int x, int y, int size, int distance, i
     if (y - distance < -1 || y + distance + size - 1 > map_data.height) {
         partially_outside_map = 1;
     }
+    return partially_outside_map;
+}
+
+// Clips the span to the tiles map_ring_is_inside_map() accepts
+static int get_inside_span(int x, int y, const ring_span *span, int *grid_offset)
+{
+    int span_y = y + span->y;
+    if (span_y < -1 || span_y > map_data.height) {
+        return 0;
+    }
+    int x_start = calc_bound(x + span->x, -1, map_data.width + 1);
+    int x_end = calc_bound(x + span->x + span->length, -1, map_data.width + 1);
+    *grid_offset = map_grid_offset(x, y) + span->grid_offset + x_start - (x + span->x);
+    return x_end - x_start;
+}
+
+static void add_desirability_at_distance(int8_t *grid, int x, int y, int size, int distance, int desirability)
+{
+    int partially_outside_map = is_partially_outside_map(x, y, size, distance);
     int base_offset = map_grid_offset(x, y);
-    int start = map_ring_start(size, distance);
-    int end = map_ring_end(size, distance);
+    int start = map_ring_span_start(size, distance);
+    int end = map_ring_span_end(size, distance);
 
     if (partially_outside_map) {
+        int has_inside_tiles = 0;
         for (int i = start; i < end; i++) {
-            const ring_tile *tile = map_ring_tile(i);
-            if (map_ring_is_inside_map(x + tile->x, y + tile->y)) {
-                desirability_grid.items[base_offset + tile->grid_offset] += desirability;
-                // BUG: bounding on wrong tile:
-                desirability_grid.items[base_offset] = calc_bound(desirability_grid.items[base_offset], -100, 100);
+            int grid_offset;
+            int length = get_inside_span(x, y, map_ring_span(i), &grid_offset);
+            if (length > 0) {
+                map_grid_add_i8_span(grid, grid_offset, length, desirability);
+                has_inside_tiles = 1;
             }
         }
+        if (has_inside_tiles) {
+            // BUG: bounding on wrong tile:
+            grid[base_offset] = calc_bound(grid[base_offset], -100, 100);
+        }
     } else {
         for (int i = start; i < end; i++) {
-            const ring_tile *tile = map_ring_tile(i);
-            desirability_grid.items[base_offset + tile->grid_offset] =
-                calc_bound(desirability_grid.items[base_offset + tile->grid_offset] + desirability, -100, 100);
+            const ring_span *span = map_ring_span(i);
+            map_grid_add_bounded_i8_span(grid, base_offset + span->grid_offset, span->length, desirability, -100, 100);
         }
     }
 }
 
-static void add_to_terrain(int x, int y, int size, int desirability, int step, int step_size, int range)
+static void add_to_terrain(int8_t *grid, const desirability_source *source)
 {
-    if (size > 0) {
-        if (range > 6) range = 6;
-        int tiles_within_step = 0;
-        int distance = 1;
-        while (range > 0) {
-            add_desirability_at_distance(x, y, size, distance, desirability);
-            distance++;
-            range--;
-            tiles_within_step++;
-            if (tiles_within_step >= step) {
-                desirability += step_size;
-                tiles_within_step = 0;
+    int values[6];
+    int num_rings = get_ring_values(source, values);
+    for (int i = 0; i < num_rings; i++) {
+        add_desirability_at_distance(grid, source->x, source->y, source->size, i + 1, values[i]);
+    }
+}
+
+// Adds the source to the same tiles as add_to_terrain, with sign 1 to add the source and -1 to remove it
+static void stamp_contributions(const desirability_source *source, int sign)
+{
+    int values[6];
+    int num_rings = get_ring_values(source, values);
+    for (int ring = 0; ring < num_rings; ring++) {
+        int distance = ring + 1;
+        int desirability = values[ring];
+        if (!desirability) {
+            continue;
+        }
+        int16_t *grid = desirability > 0 ? incremental.positive.items : incremental.negative.items;
+        int end = map_ring_span_end(source->size, distance);
+        for (int i = map_ring_span_start(source->size, distance); i < end; i++) {
+            int grid_offset;
+            int length = get_inside_span(source->x, source->y, map_ring_span(i), &grid_offset);
+            if (length > 0) {
+                map_grid_add_i16_span(grid, grid_offset, length, sign * desirability);
             }
         }
     }
 }
 
+static int has_unsafe_tiles(void)
+{
+    int unsafe = 0;
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        unsafe |= (incremental.positive.items[i] > 100) | (incremental.negative.items[i] < -100);
+    }
+    return unsafe;
+}
+
+static void set_model_source(desirability_source *source, int x, int y, int size, building_type type)
+{
+    const model_building *model = model_get_building(type);
+    source->x = x;
+    source->y = y;
+    source->size = size;
+    source->value = model->desirability_value;
+    source->step = model->desirability_step;
+    source->step_size = model->desirability_step_size;
+    source->range = model->desirability_range;
+}
+
+static void get_terrain_source(int grid_offset, int type, desirability_source *source)
+{
+    int x = map_grid_offset_to_x(grid_offset);
+    int y = map_grid_offset_to_y(grid_offset);
+    switch (type) {
+        case TERRAIN_SOURCE_PLAZA:
+            set_model_source(source, x, y, 1, BUILDING_PLAZA);
+            break;
+        case TERRAIN_SOURCE_EARTHQUAKE:
+            // earthquake fault line: slight negative
+            set_model_source(source, x, y, 1, BUILDING_HOUSE_VACANT_LOT);
+            break;
+        case TERRAIN_SOURCE_GARDEN:
+            set_model_source(source, x, y, 1, BUILDING_GARDENS);
+            break;
+        case TERRAIN_SOURCE_RUBBLE:
+            source->x = x;
+            source->y = y;
+            source->size = 1;
+            source->value = -2;
+            source->step = 1;
+            source->step_size = 1;
+            source->range = 2;
+            break;
+        default:
+            memset(source, 0, sizeof(desirability_source));
+            break;
+    }
+}
+
+static void reset_incremental(void)
+{
+    map_grid_clear_i16(incremental.positive.items);
+    map_grid_clear_i16(incremental.negative.items);
+    map_grid_clear_u8(incremental.terrain_sources.items);
+    memset(incremental.buildings, 0, sizeof(incremental.buildings));
+    incremental.highest_building_id = 0;
+    incremental.is_valid = 1;
+}
+
 static void update_buildings(void)
 {
     int max_id = building_get_highest_id();
-    for (int i = 1; i <= max_id; i++) {
+    int last_id = max_id > incremental.highest_building_id ? max_id : incremental.highest_building_id;
+    for (int i = 1; i <= last_id; i++) {
+        desirability_source source = {0};
         building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE) {
-            const model_building *model = model_get_building(b->type);
-            add_to_terrain(
-                b->x, b->y, b->size,
-                model->desirability_value,
-                model->desirability_step,
-                model->desirability_step_size,
-                model->desirability_range);
+        if (i <= max_id && b->state == BUILDING_STATE_IN_USE) {
+            set_model_source(&source, b->x, b->y, b->size, b->type);
+        }
+        desirability_source *previous = &incremental.buildings[i];
+        if (memcmp(previous, &source, sizeof(desirability_source)) != 0) {
+            stamp_contributions(previous, -1);
+            stamp_contributions(&source, 1);
+            *previous = source;
         }
     }
+    incremental.highest_building_id = max_id;
+}
+
+static int get_terrain_source_type(int grid_offset)
+{
+    int terrain = map_terrain_get(grid_offset);
+    if (map_property_is_plaza_or_earthquake(grid_offset)) {
+        if (terrain & TERRAIN_ROAD) {
+            return TERRAIN_SOURCE_PLAZA;
+        } else if (terrain & TERRAIN_ROCK) {
+            return TERRAIN_SOURCE_EARTHQUAKE;
+        } else {
+            // invalid plaza/earthquake flag
+            map_property_clear_plaza_or_earthquake(grid_offset);
+            return TERRAIN_SOURCE_NONE;
+        }
+    } else if (terrain & TERRAIN_GARDEN) {
+        return TERRAIN_SOURCE_GARDEN;
+    } else if (terrain & TERRAIN_RUBBLE) {
+        return TERRAIN_SOURCE_RUBBLE;
+    }
+    return TERRAIN_SOURCE_NONE;
 }
 
 static void update_terrain(void)
@@ -88,44 +269,76 @@ static void update_terrain(void)
     int grid_offset = map_data.start_offset;
     for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
         for (int x = 0; x < map_data.width; x++, grid_offset++) {
-            int terrain = map_terrain_get(grid_offset);
-            if (map_property_is_plaza_or_earthquake(grid_offset)) {
-                int type;
-                if (terrain & TERRAIN_ROAD) {
-                    type = BUILDING_PLAZA;
-                } else if (terrain & TERRAIN_ROCK) {
-                    // earthquake fault line: slight negative
-                    type = BUILDING_HOUSE_VACANT_LOT;
-                } else {
-                    // invalid plaza/earthquake flag
-                    map_property_clear_plaza_or_earthquake(grid_offset);
-                    continue;
-                }
-                const model_building *model = model_get_building(type);
-                add_to_terrain(x, y, 1,
-                    model->desirability_value,
-                    model->desirability_step,
-                    model->desirability_step_size,
-                    model->desirability_range);
-            } else if (terrain & TERRAIN_GARDEN) {
-                const model_building *model = model_get_building(BUILDING_GARDENS);
-                add_to_terrain(x, y, 1,
-                    model->desirability_value,
-                    model->desirability_step,
-                    model->desirability_step_size,
-                    model->desirability_range);
-            } else if (terrain & TERRAIN_RUBBLE) {
-                add_to_terrain(x, y, 1, -2, 1, 1, 2);
+            int type = get_terrain_source_type(grid_offset);
+            int previous_type = incremental.terrain_sources.items[grid_offset];
+            if (type != previous_type) {
+                desirability_source source;
+                get_terrain_source(grid_offset, previous_type, &source);
+                stamp_contributions(&source, -1);
+                get_terrain_source(grid_offset, type, &source);
+                stamp_contributions(&source, 1);
+                incremental.terrain_sources.items[grid_offset] = type;
             }
         }
     }
 }
 
+// The original update: every source in order, clamping as it goes
+static void calculate_full(int8_t *grid)
+{
+    map_grid_clear_i8(grid);
+    for (int i = 1; i <= incremental.highest_building_id; i++) {
+        add_to_terrain(grid, &incremental.buildings[i]);
+    }
+    int grid_offset = map_data.start_offset;
+    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
+        for (int x = 0; x < map_data.width; x++, grid_offset++) {
+            if (incremental.terrain_sources.items[grid_offset] != TERRAIN_SOURCE_NONE) {
+                desirability_source source;
+                get_terrain_source(grid_offset, incremental.terrain_sources.items[grid_offset], &source);
+                add_to_terrain(grid, &source);
+            }
+        }
+    }
+}
+
+static void calculate_from_contributions(int8_t *grid)
+{
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        grid[i] = (int8_t) (incremental.positive.items[i] + incremental.negative.items[i]);
+    }
+}
+
 void map_desirability_update(void)
 {
-    map_desirability_clear();
+    if (!incremental.is_valid) {
+        reset_incremental();
+    }
     update_buildings();
     update_terrain();
+    if (has_unsafe_tiles()) {
+        calculate_full(desirability_grid.items);
+        return;
+    }
+    calculate_from_contributions(desirability_grid.items);
+    if (incremental.verify) {
+        calculate_full(incremental.verify_grid.items);
+        if (memcmp(incremental.verify_grid.items, desirability_grid.items, sizeof(desirability_grid.items)) != 0) {
+            log_error("Incremental desirability differs from the full update", 0, 0);
+            incremental.verify_failures++;
+            memcpy(desirability_grid.items, incremental.verify_grid.items, sizeof(desirability_grid.items));
+        }
+    }
+}
+
+void map_desirability_set_verify(int verify)
+{
+    incremental.verify = verify;
+}
+
+int map_desirability_verify_failures(void)
+{
+    return incremental.verify_failures;
 }
 
 int map_desirability_get(int grid_offset)
@@ -158,4 +371,5 @@ void map_desirability_save_state(buffer *buf)
 void map_desirability_load_state(buffer *buf)
 {
     map_grid_load_state_i8(desirability_grid.items, buf);
+    incremental.is_valid = 0;
 }
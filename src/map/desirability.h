@@ -7,6 +7,18 @@ void map_desirability_clear(void);
 
 void map_desirability_update(void);
 
+/**
+ * Debug mode: after every incremental update, also run the full update and compare the results
+ * @param verify Whether to compare
+ */
+void map_desirability_set_verify(int verify);
+
+/**
+ * Gets the number of times the incremental update differed from the full update in debug mode
+ * @return Number of differences
+ */
+int map_desirability_verify_failures(void);
+
 int map_desirability_get(int grid_offset);
 
 int map_desirability_get_max(int x, int y, int size);
@@ -1,9 +1,95 @@
 #include "figure.h"
 
+#include "core/calc.h"
 #include "map/grid.h"
 
+#include <string.h>
+
+#define CELL_SIZE 8
+#define CELLS ((GRID_SIZE + CELL_SIZE - 1) / CELL_SIZE)
+#define ID_WORD_BITS 32
+#define ID_WORDS ((MAX_FIGURES + ID_WORD_BITS - 1) / ID_WORD_BITS)
+#define MAX_FIGURES_ON_SAME_TILE_INDEX 20
+
 static grid_u16 figures;
 
+// links back along the figure lists on each tile, so figures can be added and removed without walking the list:
+// the first figure on a tile points to the last one
+static struct {
+    int is_valid;
+    short prev[MAX_FIGURES];
+    int grid_offset[MAX_FIGURES];
+} links;
+
+// figures by the coarse cell of their last position, for distance queries
+static struct {
+    int is_valid;
+    short head[CELLS * CELLS];
+    short next[MAX_FIGURES];
+    short prev[MAX_FIGURES];
+    short cell[MAX_FIGURES];
+} cells;
+
+static int get_cell(int x, int y)
+{
+    return calc_bound(y / CELL_SIZE, 0, CELLS - 1) * CELLS + calc_bound(x / CELL_SIZE, 0, CELLS - 1);
+}
+
+static void remove_from_cell(int id)
+{
+    int cell = cells.cell[id];
+    if (cell < 0) {
+        return;
+    }
+    if (cells.prev[id]) {
+        cells.next[cells.prev[id]] = cells.next[id];
+    } else {
+        cells.head[cell] = cells.next[id];
+    }
+    if (cells.next[id]) {
+        cells.prev[cells.next[id]] = cells.prev[id];
+    }
+    cells.cell[id] = -1;
+}
+
+static void add_to_cell(const figure *f)
+{
+    int cell = get_cell(f->x, f->y);
+    cells.prev[f->id] = 0;
+    cells.next[f->id] = cells.head[cell];
+    if (cells.head[cell]) {
+        cells.prev[cells.head[cell]] = f->id;
+    }
+    cells.head[cell] = f->id;
+    cells.cell[f->id] = cell;
+}
+
+static void update_cell(const figure *f)
+{
+    if (!cells.is_valid || f->id <= 0 || f->id >= MAX_FIGURES) {
+        return;
+    }
+    if (cells.cell[f->id] != get_cell(f->x, f->y)) {
+        remove_from_cell(f->id);
+        add_to_cell(f);
+    }
+}
+
+static void rebuild_cells(void)
+{
+    memset(cells.head, 0, sizeof(cells.head));
+    for (int i = 0; i < MAX_FIGURES; i++) {
+        cells.cell[i] = -1;
+    }
+    for (int i = 1; i < MAX_FIGURES; i++) {
+        figure *f = figure_get(i);
+        if (f->state) {
+            add_to_cell(f);
+        }
+    }
+    cells.is_valid = 1;
+}
+
 int map_has_figure_at(int grid_offset)
 {
     return map_grid_is_valid_offset(grid_offset) && figures.items[grid_offset] > 0;
@@ -14,33 +100,108 @@ int map_figure_at(int grid_offset)
     return map_grid_is_valid_offset(grid_offset) ? figures.items[grid_offset] : 0;
 }
 
-static void cap_figures_on_same_tile_index(figure *f)
+static int is_linked(int id, int grid_offset)
 {
-    if (f->figures_on_same_tile_index > 20) {
-        f->figures_on_same_tile_index = 20;
+    return id > 0 && id < MAX_FIGURES && links.grid_offset[id] == grid_offset;
+}
+
+static void rebuild_links(void)
+{
+    for (int i = 0; i < MAX_FIGURES; i++) {
+        links.grid_offset[i] = -1;
     }
+    for (int grid_offset = 0; grid_offset < GRID_SIZE * GRID_SIZE; grid_offset++) {
+        int first_id = figures.items[grid_offset];
+        int last_id = 0;
+        for (int id = first_id; id > 0 && id < MAX_FIGURES && links.grid_offset[id] < 0;
+             id = figure_get(id)->next_figure_id_on_same_tile) {
+            links.grid_offset[id] = grid_offset;
+            links.prev[id] = last_id;
+            last_id = id;
+        }
+        if (last_id) {
+            links.prev[first_id] = last_id;
+        }
+    }
+    links.is_valid = 1;
+}
+
+static void ensure_links(void)
+{
+    if (!links.is_valid) {
+        rebuild_links();
+    }
+}
+
+static int count_back_to_first(int id, int first_id)
+{
+    int count = 0;
+    while (id != first_id && count < MAX_FIGURES_ON_SAME_TILE_INDEX) {
+        id = links.prev[id];
+        count++;
+    }
+    return count;
+}
+
+static void unlink_figure(figure *f)
+{
+    int first_id = figures.items[links.grid_offset[f->id]];
+    int next_id = f->next_figure_id_on_same_tile;
+    if (first_id == f->id) {
+        figures.items[links.grid_offset[f->id]] = next_id;
+        if (next_id) {
+            links.prev[next_id] = links.prev[f->id];
+        }
+    } else {
+        int prev_id = links.prev[f->id];
+        figure_get(prev_id)->next_figure_id_on_same_tile = next_id;
+        links.prev[next_id ? next_id : first_id] = prev_id;
+    }
+    links.grid_offset[f->id] = -1;
+    f->next_figure_id_on_same_tile = 0;
+}
+
+static void cut_off_next_figures(figure *f)
+{
+    // the figures after this one drop off the list of the tile this figure is still on
+    if (f->id > 0 && f->id < MAX_FIGURES && links.grid_offset[f->id] >= 0) {
+        for (int id = f->next_figure_id_on_same_tile; id > 0 && id < MAX_FIGURES && links.grid_offset[id] >= 0;
+             id = figure_get(id)->next_figure_id_on_same_tile) {
+            links.grid_offset[id] = -1;
+        }
+        links.prev[figures.items[links.grid_offset[f->id]]] = f->id;
+    }
+    f->next_figure_id_on_same_tile = 0;
 }
 
 void map_figure_add(figure *f)
 {
+    update_cell(f);
     if (!map_grid_is_valid_offset(f->grid_offset)) {
         return;
     }
+    ensure_links();
+    if (f->id > 0 && f->id < MAX_FIGURES && links.grid_offset[f->id] >= 0) {
+        unlink_figure(f);
+    }
     f->figures_on_same_tile_index = 0;
     f->next_figure_id_on_same_tile = 0;
 
-    if (figures.items[f->grid_offset]) {
-        figure *next = figure_get(figures.items[f->grid_offset]);
-        f->figures_on_same_tile_index++;
-        while (next->next_figure_id_on_same_tile) {
-            next = figure_get(next->next_figure_id_on_same_tile);
-            f->figures_on_same_tile_index++;
+    int first_id = figures.items[f->grid_offset];
+    if (first_id) {
+        int last_id = links.prev[first_id];
+        f->figures_on_same_tile_index = 1 + count_back_to_first(last_id, first_id);
+        if (f->figures_on_same_tile_index > MAX_FIGURES_ON_SAME_TILE_INDEX) {
+            f->figures_on_same_tile_index = MAX_FIGURES_ON_SAME_TILE_INDEX;
         }
-        cap_figures_on_same_tile_index(f);
-        next->next_figure_id_on_same_tile = f->id;
+        figure_get(last_id)->next_figure_id_on_same_tile = f->id;
+        links.prev[f->id] = last_id;
+        links.prev[first_id] = f->id;
     } else {
         figures.items[f->grid_offset] = f->id;
+        links.prev[f->id] = f->id;
     }
+    links.grid_offset[f->id] = f->grid_offset;
 }
 
 void map_figure_update(figure *f)
@@ -48,37 +209,38 @@ void map_figure_update(figure *f)
     if (!map_grid_is_valid_offset(f->grid_offset)) {
         return;
     }
-    f->figures_on_same_tile_index = 0;
-
-    figure *next = figure_get(figures.items[f->grid_offset]);
-    while (next->id) {
-        if (next->id == f->id) {
-            cap_figures_on_same_tile_index(f);
-            return;
-        }
-        f->figures_on_same_tile_index++;
-        next = figure_get(next->next_figure_id_on_same_tile);
+    ensure_links();
+    int first_id = figures.items[f->grid_offset];
+    if (is_linked(f->id, f->grid_offset)) {
+        f->figures_on_same_tile_index = count_back_to_first(f->id, first_id);
+        return;
     }
-    cap_figures_on_same_tile_index(f);
+    // not on this tile: the index of a figure added after the ones there
+    int count = 0;
+    for (int id = first_id; id && count < MAX_FIGURES_ON_SAME_TILE_INDEX;
+         id = figure_get(id)->next_figure_id_on_same_tile) {
+        count++;
+    }
+    f->figures_on_same_tile_index = count;
 }
 
 void map_figure_delete(figure *f)
 {
     if (!map_grid_is_valid_offset(f->grid_offset) || !figures.items[f->grid_offset]) {
+        if (links.is_valid) {
+            cut_off_next_figures(f);
+        }
         f->next_figure_id_on_same_tile = 0;
         return;
     }
-
-    if (figures.items[f->grid_offset] == f->id) {
-        figures.items[f->grid_offset] = f->next_figure_id_on_same_tile;
+    ensure_links();
+    if (is_linked(f->id, f->grid_offset)) {
+        unlink_figure(f);
     } else {
-        figure *prev = figure_get(figures.items[f->grid_offset]);
-        while (prev->id && prev->next_figure_id_on_same_tile != f->id) {
-            prev = figure_get(prev->next_figure_id_on_same_tile);
-        }
-        prev->next_figure_id_on_same_tile = f->next_figure_id_on_same_tile;
+        // like walking the whole list without finding the figure, which ends on figure 0
+        figure_get(0)->next_figure_id_on_same_tile = f->next_figure_id_on_same_tile;
+        cut_off_next_figures(f);
     }
-    f->next_figure_id_on_same_tile = 0;
 }
 
 int map_figure_foreach_until(int grid_offset, int (*callback)(figure *f))
@@ -97,9 +259,42 @@ int map_figure_foreach_until(int grid_offset, int (*callback)(figure *f))
     return 0;
 }
 
+int map_figure_ids_within_distance(int x, int y, int distance, int *ids)
+{
+    if (!cells.is_valid) {
+        rebuild_cells();
+    }
+    uint32_t found[ID_WORDS] = {0};
+    int min_x = calc_bound((x - distance) / CELL_SIZE, 0, CELLS - 1);
+    int max_x = calc_bound((x + distance) / CELL_SIZE, 0, CELLS - 1);
+    int min_y = calc_bound((y - distance) / CELL_SIZE, 0, CELLS - 1);
+    int max_y = calc_bound((y + distance) / CELL_SIZE, 0, CELLS - 1);
+    for (int cell_y = min_y; cell_y <= max_y; cell_y++) {
+        for (int cell_x = min_x; cell_x <= max_x; cell_x++) {
+            for (int id = cells.head[cell_y * CELLS + cell_x]; id; id = cells.next[id]) {
+                const figure *f = figure_get(id);
+                if (f->state && calc_maximum_distance(x, y, f->x, f->y) <= distance) {
+                    found[id / ID_WORD_BITS] |= 1u << (id % ID_WORD_BITS);
+                }
+            }
+        }
+    }
+    int count = 0;
+    for (int word = 0; word < ID_WORDS; word++) {
+        uint32_t bits = found[word];
+        while (bits) {
+            ids[count++] = word * ID_WORD_BITS + calc_lowest_set_bit(bits);
+            bits &= bits - 1;
+        }
+    }
+    return count;
+}
+
 void map_figure_clear(void)
 {
     map_grid_clear_u16(figures.items);
+    cells.is_valid = 0;
+    links.is_valid = 0;
 }
 
 void map_figure_save_state(buffer *buf)
@@ -110,4 +305,6 @@ void map_figure_save_state(buffer *buf)
 void map_figure_load_state(buffer *buf)
 {
     map_grid_load_state_u16(figures.items, buf);
+    cells.is_valid = 0;
+    links.is_valid = 0;
 }
@@ -26,6 +26,17 @@ void map_figure_delete(figure *f);
 
 int map_figure_foreach_until(int grid_offset, int (*callback)(figure *f));
 
+/**
+ * Gets all figures within a distance of a tile, as calc_maximum_distance() measures it, dead ones included.
+ * Figures are found by where they were last added to the map, so a figure that was moved must be added again.
+ * @param x X position
+ * @param y Y position
+ * @param distance Maximum distance
+ * @param ids Array of at least MAX_FIGURES entries to store the figure IDs in, in ID order
+ * @return Number of figures found
+ */
+int map_figure_ids_within_distance(int x, int y, int distance, int *ids);
+
 /**
  * Clears the map
  */
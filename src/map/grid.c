@@ -1,9 +1,18 @@
 #include "grid.h"
 
+#include "core/calc.h"
 #include "map/data.h"
 
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRID_HAS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define GRID_HAS_NEON
+#include <arm_neon.h>
+#endif
+
 #define OFFSET(x,y) (x + GRID_SIZE * y)
 
 struct map_data_t map_data;
@@ -226,6 +235,125 @@ void map_grid_copy_u16(const uint16_t *src, uint16_t *dst)
     memcpy(dst, src, GRID_SIZE * GRID_SIZE * sizeof(uint16_t));
 }
 
+// Spans are short (a ring or area row is at most a few dozen tiles), so the vector versions
+// work on 8 tiles at a time and never touch tiles outside the span
+void map_grid_add_i8_span(int8_t *grid, int grid_offset, int length, int value)
+{
+    int8_t *tiles = &grid[grid_offset];
+    int i = 0;
+#if defined(GRID_HAS_SSE2)
+    __m128i values = _mm_set1_epi8((char) value);
+    for (; i + 8 <= length; i += 8) {
+        __m128i t = _mm_loadl_epi64((const __m128i *) &tiles[i]);
+        _mm_storel_epi64((__m128i *) &tiles[i], _mm_add_epi8(t, values));
+    }
+#elif defined(GRID_HAS_NEON)
+    int8x8_t values = vdup_n_s8((int8_t) value);
+    for (; i + 8 <= length; i += 8) {
+        vst1_s8(&tiles[i], vadd_s8(vld1_s8(&tiles[i]), values));
+    }
+#endif
+    for (; i < length; i++) {
+        tiles[i] += value;
+    }
+}
+
+void map_grid_add_bounded_i8_span(int8_t *grid, int grid_offset, int length, int value, int min, int max)
+{
+    int8_t *tiles = &grid[grid_offset];
+    int i = 0;
+    // Saturating at the int8 limits first does not change the result when the bounds are within them
+    if (value >= INT8_MIN && value <= INT8_MAX && min >= INT8_MIN && max <= INT8_MAX && min <= max) {
+#if defined(GRID_HAS_SSE2)
+        // SSE2 only has unsigned byte min/max: flipping the sign bit keeps the order
+        __m128i sign = _mm_set1_epi8((char) 0x80);
+        __m128i values = _mm_set1_epi8((char) value);
+        __m128i lower = _mm_set1_epi8((char) (min ^ 0x80));
+        __m128i upper = _mm_set1_epi8((char) (max ^ 0x80));
+        for (; i + 8 <= length; i += 8) {
+            __m128i t = _mm_adds_epi8(_mm_loadl_epi64((const __m128i *) &tiles[i]), values);
+            t = _mm_xor_si128(t, sign);
+            t = _mm_min_epu8(_mm_max_epu8(t, lower), upper);
+            _mm_storel_epi64((__m128i *) &tiles[i], _mm_xor_si128(t, sign));
+        }
+#elif defined(GRID_HAS_NEON)
+        int8x8_t values = vdup_n_s8((int8_t) value);
+        int8x8_t lower = vdup_n_s8((int8_t) min);
+        int8x8_t upper = vdup_n_s8((int8_t) max);
+        for (; i + 8 <= length; i += 8) {
+            int8x8_t t = vqadd_s8(vld1_s8(&tiles[i]), values);
+            vst1_s8(&tiles[i], vmin_s8(vmax_s8(t, lower), upper));
+        }
+#endif
+    }
+    for (; i < length; i++) {
+        tiles[i] = calc_bound(tiles[i] + value, min, max);
+    }
+}
+
+void map_grid_add_i16_span(int16_t *grid, int grid_offset, int length, int value)
+{
+    int16_t *tiles = &grid[grid_offset];
+    int i = 0;
+#if defined(GRID_HAS_SSE2)
+    __m128i values = _mm_set1_epi16((short) value);
+    for (; i + 8 <= length; i += 8) {
+        __m128i t = _mm_loadu_si128((const __m128i *) &tiles[i]);
+        _mm_storeu_si128((__m128i *) &tiles[i], _mm_add_epi16(t, values));
+    }
+#elif defined(GRID_HAS_NEON)
+    int16x8_t values = vdupq_n_s16((int16_t) value);
+    for (; i + 8 <= length; i += 8) {
+        vst1q_s16(&tiles[i], vaddq_s16(vld1q_s16(&tiles[i]), values));
+    }
+#endif
+    for (; i < length; i++) {
+        tiles[i] += value;
+    }
+}
+
+void map_grid_or_u16_span(uint16_t *grid, int grid_offset, int length, uint16_t bits)
+{
+    uint16_t *tiles = &grid[grid_offset];
+    int i = 0;
+#if defined(GRID_HAS_SSE2)
+    __m128i values = _mm_set1_epi16((short) bits);
+    for (; i + 8 <= length; i += 8) {
+        __m128i t = _mm_loadu_si128((const __m128i *) &tiles[i]);
+        _mm_storeu_si128((__m128i *) &tiles[i], _mm_or_si128(t, values));
+    }
+#elif defined(GRID_HAS_NEON)
+    uint16x8_t values = vdupq_n_u16(bits);
+    for (; i + 8 <= length; i += 8) {
+        vst1q_u16(&tiles[i], vorrq_u16(vld1q_u16(&tiles[i]), values));
+    }
+#endif
+    for (; i < length; i++) {
+        tiles[i] |= bits;
+    }
+}
+
+void map_grid_and_u16_span(uint16_t *grid, int grid_offset, int length, uint16_t mask)
+{
+    uint16_t *tiles = &grid[grid_offset];
+    int i = 0;
+#if defined(GRID_HAS_SSE2)
+    __m128i values = _mm_set1_epi16((short) mask);
+    for (; i + 8 <= length; i += 8) {
+        __m128i t = _mm_loadu_si128((const __m128i *) &tiles[i]);
+        _mm_storeu_si128((__m128i *) &tiles[i], _mm_and_si128(t, values));
+    }
+#elif defined(GRID_HAS_NEON)
+    uint16x8_t values = vdupq_n_u16(mask);
+    for (; i + 8 <= length; i += 8) {
+        vst1q_u16(&tiles[i], vandq_u16(vld1q_u16(&tiles[i]), values));
+    }
+#endif
+    for (; i < length; i++) {
+        tiles[i] &= mask;
+    }
+}
+
 void map_grid_save_state_u8(const uint8_t *grid, buffer *buf)
 {
     buffer_write_raw(buf, grid, GRID_SIZE * GRID_SIZE);
@@ -85,6 +85,18 @@ void map_grid_copy_u8(const uint8_t *src, uint8_t *dst);
 void map_grid_copy_u16(const uint16_t *src, uint16_t *dst);
 
 
+// Row spans: length consecutive tiles starting at grid_offset
+void map_grid_add_i8_span(int8_t *grid, int grid_offset, int length, int value);
+
+void map_grid_add_bounded_i8_span(int8_t *grid, int grid_offset, int length, int value, int min, int max);
+
+void map_grid_add_i16_span(int16_t *grid, int grid_offset, int length, int value);
+
+void map_grid_or_u16_span(uint16_t *grid, int grid_offset, int length, uint16_t bits);
+
+void map_grid_and_u16_span(uint16_t *grid, int grid_offset, int length, uint16_t mask);
+
+
 void map_grid_save_state_u8(const uint8_t *grid, buffer *buf);
 
 void map_grid_save_state_i8(const int8_t *grid, buffer *buf);
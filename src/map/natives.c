@@ -53,9 +53,10 @@ static void determine_meeting_center(void)
 {
     // gather list of meeting centers
     building_list_small_clear();
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_NATIVE_MEETING); i;
+         i = building_next_of_type(BUILDING_NATIVE_MEETING, i)) {
         building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_NATIVE_MEETING) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             building_list_small_add(i);
         }
     }
@@ -65,9 +66,9 @@ static void determine_meeting_center(void)
     }
     const int *meetings = building_list_small_items();
     // determine closest meeting center for hut
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_NATIVE_HUT); i; i = building_next_of_type(BUILDING_NATIVE_HUT, i)) {
         building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_NATIVE_HUT) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             int min_dist = 1000;
             int min_meeting_id = 0;
             for (int n = 0; n < total_meetings; n++) {
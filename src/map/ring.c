@@ -6,8 +6,41 @@
 static struct {
     ring_tile tiles[1080];
     int index[6][7];
+    ring_span spans[1080];
+    int span_index[6][8];
 } data;
 
+static int compare_tiles_by_row(const ring_tile *a, const ring_tile *b)
+{
+    return a->y != b->y ? a->y - b->y : a->x - b->x;
+}
+
+static int create_spans(int start, int end, int span_index)
+{
+    ring_tile sorted[4 * 4 + 8 * 6];
+    int num_tiles = end - start;
+    for (int i = 0; i < num_tiles; i++) {
+        int j = i;
+        for (; j > 0 && compare_tiles_by_row(&data.tiles[start + i], &sorted[j - 1]) < 0; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = data.tiles[start + i];
+    }
+    for (int i = 0; i < num_tiles; i++) {
+        ring_span *span = i > 0 ? &data.spans[span_index - 1] : 0;
+        if (span && sorted[i].y == span->y && sorted[i].x == span->x + span->length) {
+            span->length++;
+        } else {
+            span = &data.spans[span_index++];
+            span->x = sorted[i].x;
+            span->y = sorted[i].y;
+            span->length = 1;
+            span->grid_offset = map_grid_delta(span->x, span->y);
+        }
+    }
+    return span_index;
+}
+
 void map_ring_init(void)
 {
     int index = 0;
@@ -50,6 +83,14 @@ void map_ring_init(void)
     for (int i = 0; i < index; i++) {
         data.tiles[i].grid_offset = map_grid_delta(data.tiles[i].x, data.tiles[i].y);
     }
+    int span_index = 0;
+    for (int size = 1; size <= 5; size++) {
+        for (int dist = 1; dist <= 6; dist++) {
+            data.span_index[size][dist] = span_index;
+            span_index = create_spans(map_ring_start(size, dist), map_ring_end(size, dist), span_index);
+            data.span_index[size][dist + 1] = span_index;
+        }
+    }
 }
 
 int map_ring_start(int size, int distance)
@@ -72,3 +113,18 @@ const ring_tile *map_ring_tile(int index)
 {
     return &data.tiles[index];
 }
+
+int map_ring_span_start(int size, int distance)
+{
+    return data.span_index[size][distance];
+}
+
+int map_ring_span_end(int size, int distance)
+{
+    return data.span_index[size][distance + 1];
+}
+
+const ring_span *map_ring_span(int index)
+{
+    return &data.spans[index];
+}
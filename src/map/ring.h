@@ -7,6 +7,13 @@ typedef struct {
     int grid_offset;
 } ring_tile;
 
+typedef struct {
+    int x;
+    int y;
+    int length;
+    int grid_offset;
+} ring_span;
+
 void map_ring_init(void);
 
 int map_ring_start(int size, int distance);
@@ -17,4 +24,11 @@ int map_ring_is_inside_map(int x, int y);
 
 const ring_tile *map_ring_tile(int index);
 
+// The ring tiles grouped into runs of consecutive tiles on the same row: same tiles, different order
+int map_ring_span_start(int size, int distance);
+
+int map_ring_span_end(int size, int distance);
+
+const ring_span *map_ring_span(int index);
+
 #endif // MAP_RING_H
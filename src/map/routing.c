@@ -18,16 +18,31 @@ static const int ROUTE_OFFSETS[] = {-162, 1, 162, -1, -161, 163, 161, -163};
 
 static grid_i16 routing_distance;
 
+static grid_u16 routing_generation;
+static uint16_t current_generation;
+
 static struct {
     int total_routes_calculated;
     int enemy_routes_calculated;
 } stats = {0, 0};
 
-static struct {
+typedef struct {
     int head;
     int tail;
     int items[MAX_QUEUE];
-} queue;
+} routing_queue;
+
+static routing_queue queue;
+
+static struct {
+    int active;
+    int dest_x;
+    int dest_y;
+    int estimate;
+    routing_queue *current;
+    routing_queue *next;
+    routing_queue next_queue;
+} astar;
 
 static grid_u8 water_drag;
 
@@ -35,14 +50,39 @@ static struct {
     int through_building_id;
 } state;
 
+/**
+ * A distance only counts when it was written during the current generation, so clearing
+ * the distances is a matter of starting a new generation rather than wiping the grid
+ */
 static void clear_distances(void)
 {
-    map_grid_clear_i16(routing_distance.items);
+    if (++current_generation == 0) {
+        map_grid_clear_u16(routing_generation.items);
+        current_generation = 1;
+    }
 }
 
+static int distance_at(int grid_offset)
+{
+    return routing_generation.items[grid_offset] == current_generation ?
+        routing_distance.items[grid_offset] : 0;
+}
+
+static void set_distance(int grid_offset, int dist)
+{
+    routing_distance.items[grid_offset] = dist;
+    routing_generation.items[grid_offset] = current_generation;
+}
+
+static void astar_enqueue(int next_offset, int dist);
+
 static void enqueue(int next_offset, int dist)
 {
-    routing_distance.items[next_offset] = dist;
+    set_distance(next_offset, dist);
+    if (astar.active) {
+        astar_enqueue(next_offset, dist);
+        return;
+    }
     queue.items[queue.tail++] = next_offset;
     if (queue.tail >= MAX_QUEUE) {
         queue.tail = 0;
@@ -51,11 +91,105 @@ static void enqueue(int next_offset, int dist)
 
 static int valid_offset(int grid_offset)
 {
-    return map_grid_is_valid_offset(grid_offset) && routing_distance.items[grid_offset] == 0;
+    return map_grid_is_valid_offset(grid_offset) && distance_at(grid_offset) == 0;
+}
+
+static int astar_estimate(int offset, int dist)
+{
+    int dx = offset % GRID_SIZE - astar.dest_x;
+    int dy = offset / GRID_SIZE - astar.dest_y;
+    return dist + (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+}
+
+static void push(routing_queue *q, int offset)
+{
+    q->items[q->tail++] = offset;
+    if (q->tail >= MAX_QUEUE) {
+        q->tail = 0;
+    }
+}
+
+static void astar_enqueue(int next_offset, int dist)
+{
+    // with a consistent estimate on a 4-connected grid, a neighbour is either
+    // as promising as the current tile or exactly two steps worse
+    if (astar_estimate(next_offset, dist) == astar.estimate) {
+        push(astar.current, next_offset);
+    } else {
+        push(astar.next, next_offset);
+    }
+}
+
+/**
+ * Goal-directed alternative to the breadth-first flood for point-to-point routes.
+ *
+ * The search continues until every tile with an estimate equal to the route length
+ * has been expanded, so all tiles on any shortest route carry the same distance as
+ * the breadth-first flood would give them. Since map_routing_get_path() only ever
+ * steps onto tiles on a shortest route, the resulting path is identical.
+ * Tiles further away from the straight line are not visited at all.
+ */
+static void route_queue_astar(int source, int dest, void (*callback)(int next_offset, int dist))
+{
+    clear_distances();
+    astar.dest_x = dest % GRID_SIZE;
+    astar.dest_y = dest / GRID_SIZE;
+    astar.current = &queue;
+    astar.next = &astar.next_queue;
+    astar.current->head = astar.current->tail = 0;
+    astar.next->head = astar.next->tail = 0;
+    astar.estimate = astar_estimate(source, 1);
+    astar.active = 1;
+    enqueue(source, 1);
+    int found = 0;
+    while (1) {
+        if (astar.current->head == astar.current->tail) {
+            if (found || astar.next->head == astar.next->tail) {
+                break;
+            }
+            routing_queue *tmp = astar.current;
+            astar.current = astar.next;
+            astar.next = tmp;
+            astar.next->head = astar.next->tail = 0;
+            astar.estimate += 2;
+        }
+        int offset = astar.current->items[astar.current->head];
+        if (++astar.current->head >= MAX_QUEUE) {
+            astar.current->head = 0;
+        }
+        int dist = distance_at(offset);
+        if (astar_estimate(offset, dist) != astar.estimate) {
+            // outdated entry: the tile has since been reached through a shorter route
+            continue;
+        }
+        if (offset == dest) {
+            found = 1;
+            continue;
+        }
+        dist++;
+        for (int i = 0; i < 4; i++) {
+            int next_offset = offset + ROUTE_OFFSETS[i];
+            if (map_grid_is_valid_offset(next_offset) &&
+                (distance_at(next_offset) == 0 || distance_at(next_offset) > dist)) {
+                callback(next_offset, dist);
+            }
+        }
+    }
+    astar.active = 0;
+}
+
+static int is_inside_map(int grid_offset)
+{
+    return map_grid_is_valid_offset(grid_offset) &&
+        map_grid_is_inside(map_grid_offset_to_x(grid_offset), map_grid_offset_to_y(grid_offset), 1);
 }
 
 static void route_queue(int source, int dest, void (*callback)(int next_offset, int dist))
 {
+    if (is_inside_map(dest)) {
+        route_queue_astar(source, dest, callback);
+        return;
+    }
     clear_distances();
     queue.head = queue.tail = 0;
     enqueue(source, 1);
@@ -64,7 +198,7 @@ static void route_queue(int source, int dest, void (*callback)(int next_offset,
         if (offset == dest) {
             break;
         }
-        int dist = 1 + routing_distance.items[offset];
+        int dist = 1 + distance_at(offset);
         for (int i = 0; i < 4; i++) {
             if (valid_offset(offset + ROUTE_OFFSETS[i])) {
                 callback(offset + ROUTE_OFFSETS[i], dist);
@@ -83,7 +217,7 @@ static void route_queue_until(int source, int (*callback)(int next_offset, int d
     enqueue(source, 1);
     while (queue.head != queue.tail) {
         int offset = queue.items[queue.head];
-        int dist = 1 + routing_distance.items[offset];
+        int dist = 1 + distance_at(offset);
         for (int i = 0; i < 4; i++) {
             if (valid_offset(offset + ROUTE_OFFSETS[i])) {
                 if (callback(offset + ROUTE_OFFSETS[i], dist) == UNTIL_STOP) {
@@ -97,8 +231,27 @@ static void route_queue_until(int source, int (*callback)(int next_offset, int d
     }
 }
 
+static int flood_would_reach(int dest, int max_tiles)
+{
+    if (map_grid_width() * map_grid_height() <= max_tiles) {
+        return 1;
+    }
+    // the flood reaches the destination when it visits its predecessor; at most all
+    // tiles within that distance are visited before, which form a diamond shape
+    int radius = distance_at(dest) - 2;
+    return 2 * radius * radius + 2 * radius + 1 <= max_tiles;
+}
+
 static void route_queue_max(int source, int dest, int max_tiles, void (*callback)(int, int))
 {
+    if (is_inside_map(dest)) {
+        route_queue_astar(source, dest, callback);
+        if (!distance_at(dest) || flood_would_reach(dest, max_tiles)) {
+            return;
+        }
+        // the flood may have hit the tile limit before reaching the destination:
+        // run it to get the exact same result
+    }
     clear_distances();
     queue.head = queue.tail = 0;
     enqueue(source, 1);
@@ -107,7 +260,7 @@ static void route_queue_max(int source, int dest, int max_tiles, void (*callback
         int offset = queue.items[queue.head];
         if (offset == dest) break;
         if (++tiles > max_tiles) break;
-        int dist = 1 + routing_distance.items[offset];
+        int dist = 1 + distance_at(offset);
         for (int i = 0; i < 4; i++) {
             if (valid_offset(offset + ROUTE_OFFSETS[i])) {
                 callback(offset + ROUTE_OFFSETS[i], dist);
@@ -138,7 +291,7 @@ static void route_queue_boat(int source, void (*callback)(int, int))
                 queue.tail = 0;
             }
         } else {
-            int dist = 1 + routing_distance.items[offset];
+            int dist = 1 + distance_at(offset);
             for (int i = 0; i < 4; i++) {
                 if (valid_offset(offset + ROUTE_OFFSETS[i])) {
                     callback(offset + ROUTE_OFFSETS[i], dist);
@@ -162,7 +315,7 @@ static void route_queue_dir8(int source, void (*callback)(int, int))
             break;
         }
         int offset = queue.items[queue.head];
-        int dist = 1 + routing_distance.items[offset];
+        int dist = 1 + distance_at(offset);
         for (int i = 0; i < 8; i++) {
             if (valid_offset(offset + ROUTE_OFFSETS[i])) {
                 callback(offset + ROUTE_OFFSETS[i], dist);
@@ -193,7 +346,7 @@ static void callback_calc_distance_water_boat(int next_offset, int dist)
         terrain_water.items[next_offset] != WATER_N3_LOW_BRIDGE) {
         enqueue(next_offset, dist);
         if (terrain_water.items[next_offset] == WATER_N2_MAP_EDGE) {
-            routing_distance.items[next_offset] += 4;
+            set_distance(next_offset, distance_at(next_offset) + 4);
         }
     }
 }
@@ -238,7 +391,7 @@ static void callback_calc_distance_build_road(int next_offset, int dist)
     switch (terrain_land_citizen.items[next_offset]) {
         case CITIZEN_N3_AQUEDUCT:
             if (!map_can_place_road_under_aqueduct(next_offset)) {
-                routing_distance.items[next_offset] = -1;
+                set_distance(next_offset, -1);
                 blocked = 1;
             }
             break;
@@ -275,7 +428,7 @@ static void callback_calc_distance_build_aqueduct(int next_offset, int dist)
             break;
     }
     if (map_terrain_is(next_offset, TERRAIN_ROAD) && !map_can_place_aqueduct_on_road(next_offset)) {
-        routing_distance.items[next_offset] = -1;
+        set_distance(next_offset, -1);
         blocked = 1;
     }
     if (!blocked) {
@@ -393,7 +546,7 @@ int map_routing_citizen_can_travel_over_land(int src_x, int src_y, int dst_x, in
     int dst_offset = map_grid_offset(dst_x, dst_y);
     ++stats.total_routes_calculated;
     route_queue(src_offset, dst_offset, callback_travel_citizen_land);
-    return routing_distance.items[dst_offset] != 0;
+    return distance_at(dst_offset) != 0;
 }
 
 static void callback_travel_citizen_road_garden(int next_offset, int dist)
@@ -410,7 +563,7 @@ int map_routing_citizen_can_travel_over_road_garden(int src_x, int src_y, int ds
     int dst_offset = map_grid_offset(dst_x, dst_y);
     ++stats.total_routes_calculated;
     route_queue(src_offset, dst_offset, callback_travel_citizen_road_garden);
-    return routing_distance.items[dst_offset] != 0;
+    return distance_at(dst_offset) != 0;
 }
 
 static void callback_travel_walls(int next_offset, int dist)
@@ -427,7 +580,7 @@ int map_routing_can_travel_over_walls(int src_x, int src_y, int dst_x, int dst_y
     int dst_offset = map_grid_offset(dst_x, dst_y);
     ++stats.total_routes_calculated;
     route_queue(src_offset, dst_offset, callback_travel_walls);
-    return routing_distance.items[dst_offset] != 0;
+    return distance_at(dst_offset) != 0;
 }
 
 static void callback_travel_noncitizen_land_through_building(int next_offset, int dist)
@@ -465,7 +618,7 @@ int map_routing_noncitizen_can_travel_over_land(
     } else {
         route_queue_max(src_offset, dst_offset, max_tiles, callback_travel_noncitizen_land);
     }
-    return routing_distance.items[dst_offset] != 0;
+    return distance_at(dst_offset) != 0;
 }
 
 static void callback_travel_noncitizen_through_everything(int next_offset, int dist)
@@ -481,7 +634,12 @@ int map_routing_noncitizen_can_travel_through_everything(int src_x, int src_y, i
     int dst_offset = map_grid_offset(dst_x, dst_y);
     ++stats.total_routes_calculated;
     route_queue(src_offset, dst_offset, callback_travel_noncitizen_through_everything);
-    return routing_distance.items[dst_offset] != 0;
+    return distance_at(dst_offset) != 0;
+}
+
+void map_routing_count_cached_route(void)
+{
+    ++stats.total_routes_calculated;
 }
 
 void map_routing_block(int x, int y, int size)
@@ -491,14 +649,14 @@ void map_routing_block(int x, int y, int size)
     }
     for (int dy = 0; dy < size; dy++) {
         for (int dx = 0; dx < size; dx++) {
-            routing_distance.items[map_grid_offset(x+dx, y+dy)] = 0;
+            set_distance(map_grid_offset(x+dx, y+dy), 0);
         }
     }
 }
 
 int map_routing_distance(int grid_offset)
 {
-    return routing_distance.items[grid_offset];
+    return distance_at(grid_offset);
 }
 
 void map_routing_save_state(buffer *buf)
@@ -28,6 +28,8 @@ int map_routing_noncitizen_can_travel_over_land(
     int src_x, int src_y, int dst_x, int dst_y, int only_through_building_id, int max_tiles);
 int map_routing_noncitizen_can_travel_through_everything(int src_x, int src_y, int dst_x, int dst_y);
 
+void map_routing_count_cached_route(void);
+
 void map_routing_block(int x, int y, int size);
 
 void map_routing_save_state(buffer *buf);
@@ -13,6 +13,11 @@
 #include "map/sprite.h"
 #include "map/terrain.h"
 
+static struct {
+    int land_citizen;
+    int walls;
+} versions;
+
 static void map_routing_update_land_noncitizen(void);
 
 void map_routing_update_all(void)
@@ -108,6 +113,7 @@ static int get_land_type_citizen_aqueduct(int grid_offset)
 
 void map_routing_update_land_citizen(void)
 {
+    versions.land_citizen++;
     map_grid_init_i8(terrain_land_citizen.items, -1);
     int grid_offset = map_data.start_offset;
     for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
@@ -273,6 +279,7 @@ static int count_adjacent_wall_tiles(int grid_offset)
 
 void map_routing_update_walls(void)
 {
+    versions.walls++;
     map_grid_init_i8(terrain_walls.items, -1);
     int grid_offset = map_data.start_offset;
     for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
@@ -292,6 +299,16 @@ void map_routing_update_walls(void)
     }
 }
 
+int map_routing_land_citizen_version(void)
+{
+    return versions.land_citizen;
+}
+
+int map_routing_walls_version(void)
+{
+    return versions.walls;
+}
+
 int map_routing_is_wall_passable(int grid_offset)
 {
     return terrain_walls.items[grid_offset] == WALL_0_PASSABLE;
@@ -38,9 +38,7 @@ void map_terrain_add_with_radius(int x, int y, int size, int radius, int terrain
     map_grid_get_area(x, y, size, radius, &x_min, &y_min, &x_max, &y_max);
 
     for (int yy = y_min; yy <= y_max; yy++) {
-        for (int xx = x_min; xx <= x_max; xx++) {
-            map_terrain_add(map_grid_offset(xx, yy), terrain);
-        }
+        map_grid_or_u16_span(terrain_grid.items, map_grid_offset(x_min, yy), x_max - x_min + 1, terrain);
     }
 }
 
@@ -50,9 +48,7 @@ void map_terrain_remove_with_radius(int x, int y, int size, int radius, int terr
     map_grid_get_area(x, y, size, radius, &x_min, &y_min, &x_max, &y_max);
 
     for (int yy = y_min; yy <= y_max; yy++) {
-        for (int xx = x_min; xx <= x_max; xx++) {
-            map_terrain_remove(map_grid_offset(xx, yy), terrain);
-        }
+        map_grid_and_u16_span(terrain_grid.items, map_grid_offset(x_min, yy), x_max - x_min + 1, ~terrain);
     }
 }
 
@@ -208,9 +208,9 @@ int map_water_determine_orientation_size3(int x, int y, int adjust_xy,
 int map_water_get_wharf_for_new_fishing_boat(figure *boat, map_point *tile)
 {
     building *wharf = 0;
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_WHARF); i; i = building_next_of_type(BUILDING_WHARF, i)) {
         building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_WHARF) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             int wharf_boat_id = b->data.industry.fishing_boat_id;
             if (!wharf_boat_id || wharf_boat_id == boat->id) {
                 wharf = b;
@@ -47,14 +47,17 @@ static void mark_well_access(int well_id, int radius)
 void map_water_supply_update_houses(void)
 {
     building_list_small_clear();
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_WELL); i; i = building_next_of_type(BUILDING_WELL, i)) {
+        if (building_get(i)->state == BUILDING_STATE_IN_USE) {
+            building_list_small_add(i);
+        }
+    }
+    for (int i = building_first_house(); i; i = building_next_house(i)) {
         building *b = building_get(i);
         if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
-        if (b->type == BUILDING_WELL) {
-            building_list_small_add(i);
-        } else if (b->house_size) {
+        if (b->house_size) {
             b->has_water_access = 0;
             b->has_well_access = 0;
             if (map_terrain_exists_tile_in_area_with_type(
@@ -150,9 +153,9 @@ void map_water_supply_update_reservoir_fountain(void)
     set_all_aqueducts_to_no_water();
     building_list_large_clear(1);
     // mark reservoirs next to water
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_RESERVOIR); i; i = building_next_of_type(BUILDING_RESERVOIR, i)) {
         building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE && b->type == BUILDING_RESERVOIR) {
+        if (b->state == BUILDING_STATE_IN_USE) {
             building_list_large_add(i);
             if (map_terrain_exists_tile_in_area_with_type(b->x - 1, b->y - 1, 5, TERRAIN_WATER)) {
                 b->has_water_access = 2;
@@ -187,9 +190,9 @@ void map_water_supply_update_reservoir_fountain(void)
         }
     }
     // fountains
-    for (int i = 1; i < MAX_BUILDINGS; i++) {
+    for (int i = building_first_of_type(BUILDING_FOUNTAIN); i; i = building_next_of_type(BUILDING_FOUNTAIN, i)) {
         building *b = building_get(i);
-        if (b->state != BUILDING_STATE_IN_USE || b->type != BUILDING_FOUNTAIN) {
+        if (b->state != BUILDING_STATE_IN_USE) {
             continue;
         }
         int des = map_desirability_get(b->grid_offset);
@@ -87,10 +87,16 @@ typedef const char *dir_name;
 
 #ifdef _WIN32
 #include <direct.h>
+#include <io.h>
 #else
 #include <unistd.h>
 #endif
 
+#if !defined(_WIN32) && !defined(__vita__) && !defined(__SWITCH__)
+#define USE_MMAP
+#include <sys/mman.h>
+#endif
+
 #ifdef __EMSCRIPTEN__
 static int writing_to_file;
 #endif
@@ -248,6 +254,16 @@ int platform_file_manager_remove_file(const char *filename)
     return result == 0;
 }
 
+int platform_file_manager_rename_file(const char *old_filename, const char *new_filename)
+{
+    wchar_t *wold = utf8_to_wchar(old_filename);
+    wchar_t *wnew = utf8_to_wchar(new_filename);
+    int result = MoveFileExW(wold, wnew, MOVEFILE_REPLACE_EXISTING);
+    free(wold);
+    free(wnew);
+    return result != 0;
+}
+
 #elif defined(__ANDROID__)
 
 FILE *platform_file_manager_open_file(const char *filename, const char *mode)
@@ -264,6 +280,12 @@ int platform_file_manager_remove_file(const char *filename)
     return android_remove_file(filename);
 }
 
+int platform_file_manager_rename_file(const char *old_filename, const char *new_filename)
+{
+    // files are accessed through the storage access framework, which does not allow renaming
+    return 0;
+}
+
 #elif defined(__EMSCRIPTEN__)
 
 FILE *platform_file_manager_open_file(const char *filename, const char *mode)
@@ -283,6 +305,17 @@ int platform_file_manager_remove_file(const char *filename)
     return 0;
 }
 
+int platform_file_manager_rename_file(const char *old_filename, const char *new_filename)
+{
+    if (rename(old_filename, new_filename) == 0) {
+        EM_ASM(
+            Module.syncFS();
+        );
+        return 1;
+    }
+    return 0;
+}
+
 #else
 
 FILE *platform_file_manager_open_file(const char *filename, const char *mode)
@@ -307,6 +340,26 @@ int platform_file_manager_remove_file(const char *filename)
     return remove(filename) == 0;
 }
 
+int platform_file_manager_rename_file(const char *old_filename, const char *new_filename)
+{
+#ifdef USE_FILE_CACHE
+    char temp_filename[FILE_NAME_MAX];
+    strncpy(temp_filename, new_filename, FILE_NAME_MAX - 1);
+    temp_filename[FILE_NAME_MAX - 1] = 0;
+    int new_file_exists = file_exists(temp_filename, NOT_LOCALIZED);
+#endif
+    if (rename(old_filename, new_filename) != 0) {
+        return 0;
+    }
+#ifdef USE_FILE_CACHE
+    platform_file_manager_cache_delete_file_info(old_filename);
+    if (!new_file_exists) {
+        platform_file_manager_cache_add_file_info(new_filename);
+    }
+#endif
+    return 1;
+}
+
 #endif
 
 int platform_file_manager_close_file(FILE *stream)
@@ -322,3 +375,93 @@ int platform_file_manager_close_file(FILE *stream)
 #endif
     return result;
 }
+
+#if defined(_WIN32)
+
+void *platform_file_manager_map_file(FILE *stream, size_t *size)
+{
+    HANDLE file = (HANDLE) _get_osfhandle(_fileno(stream));
+    LARGE_INTEGER file_size;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0) {
+        return NULL;
+    }
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        return NULL;
+    }
+    // the view keeps the mapping alive
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) {
+        return NULL;
+    }
+    *size = (size_t) file_size.QuadPart;
+    return data;
+}
+
+void platform_file_manager_unmap_file(void *data, size_t size)
+{
+    UnmapViewOfFile(data);
+}
+
+int platform_file_manager_get_file_info(FILE *stream, int64_t *size, int64_t *modified_time)
+{
+    struct _stat64 file_info;
+    if (_fstat64(_fileno(stream), &file_info) != 0) {
+        return 0;
+    }
+    *size = file_info.st_size;
+    *modified_time = file_info.st_mtime;
+    return 1;
+}
+
+#elif defined(USE_MMAP)
+
+void *platform_file_manager_map_file(FILE *stream, size_t *size)
+{
+    int fd = fileno(stream);
+    struct stat file_info;
+    if (fd < 0 || fstat(fd, &file_info) != 0 || !S_ISREG(file_info.st_mode) || file_info.st_size <= 0) {
+        return NULL;
+    }
+    void *data = mmap(NULL, (size_t) file_info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    *size = (size_t) file_info.st_size;
+    return data;
+}
+
+void platform_file_manager_unmap_file(void *data, size_t size)
+{
+    munmap(data, size);
+}
+
+int platform_file_manager_get_file_info(FILE *stream, int64_t *size, int64_t *modified_time)
+{
+    struct stat file_info;
+    if (fstat(fileno(stream), &file_info) != 0) {
+        return 0;
+    }
+    *size = file_info.st_size;
+    *modified_time = file_info.st_mtime;
+    return 1;
+}
+
+#else
+
+void *platform_file_manager_map_file(FILE *stream, size_t *size)
+{
+    return NULL;
+}
+
+void platform_file_manager_unmap_file(void *data, size_t size)
+{
+}
+
+int platform_file_manager_get_file_info(FILE *stream, int64_t *size, int64_t *modified_time)
+{
+    return 0;
+}
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef PLATFORM_FILE_MANAGER_H
 #define PLATFORM_FILE_MANAGER_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 enum {
@@ -81,4 +83,36 @@ int platform_file_manager_close_file(FILE *stream);
  */
 int platform_file_manager_remove_file(const char *filename);
 
+/**
+ * Renames a file, replacing the new file if it exists
+ * @param old_filename The file to rename
+ * @param new_filename The new name
+ * @return true if the file was renamed, false otherwise
+ */
+int platform_file_manager_rename_file(const char *old_filename, const char *new_filename);
+
+/**
+ * Maps the contents of an open file into memory for reading
+ * @param stream The file to map, may be closed after mapping
+ * @param size OUT: size of the mapped file
+ * @return Pointer to the file contents, NULL if the platform cannot map the file
+ */
+void *platform_file_manager_map_file(FILE *stream, size_t *size);
+
+/**
+ * Unmaps a file mapped by platform_file_manager_map_file
+ * @param data The mapped file contents
+ * @param size The size of the mapped file
+ */
+void platform_file_manager_unmap_file(void *data, size_t size);
+
+/**
+ * Gets the size and modification time of an open file
+ * @param stream The file
+ * @param size OUT: size of the file in bytes
+ * @param modified_time OUT: time of the last modification, in seconds
+ * @return true if the information is available, false otherwise
+ */
+int platform_file_manager_get_file_info(FILE *stream, int64_t *size, int64_t *modified_time);
+
 #endif // PLATFORM_FILE_MANAGER_H
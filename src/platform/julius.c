@@ -7,6 +7,7 @@
 #include "core/lang.h"
 #include "core/time.h"
 #include "game/game.h"
+#include "game/profiler.h"
 #include "game/settings.h"
 #include "game/system.h"
 #include "graphics/screen.h"
@@ -34,7 +35,7 @@
 #include "platform/switch/switch.h"
 #include "platform/vita/vita.h"
 
-#if defined(_WIN32) || defined(__vita__) || defined(__SWITCH__) || defined(__ANDROID__)
+#if defined(_WIN32) || defined(__vita__) || defined(__SWITCH__) || defined(__ANDROID__) || defined(DRAW_FPS)
 #include <string.h>
 #endif
 
@@ -61,7 +62,8 @@ enum {
 static struct {
     int active;
     int quit;
-} data = { 1, 0 };
+    const char *profile_csv_file;
+} data = { 1, 0, 0 };
 
 static void exit_with_status(int status)
 {
@@ -159,6 +161,17 @@ void system_set_fullscreen(int fullscreen)
     post_event(fullscreen ? USER_EVENT_FULLSCREEN : USER_EVENT_WINDOWED);
 }
 
+uint64_t system_get_micros(void)
+{
+    static Uint64 frequency;
+    if (!frequency) {
+        frequency = SDL_GetPerformanceFrequency();
+    }
+    Uint64 counter = SDL_GetPerformanceCounter();
+    // split the calculation to prevent overflow on high-frequency counters
+    return (counter / frequency) * 1000000 + (counter % frequency) * 1000000 / frequency;
+}
+
 #ifdef _WIN32
 #define PLATFORM_ENABLE_PER_FRAME_CALLBACK
 static void platform_per_frame_callback(void)
@@ -172,8 +185,27 @@ static struct {
     int frame_count;
     int last_fps;
     Uint32 last_update_time;
+    profiler_frame_summary slowest_frame;
+    profiler_frame_summary last_slowest_frame;
 } fps;
 
+static void draw_profiler_summary(int y_offset)
+{
+    const profiler_frame_summary *frame = &fps.last_slowest_frame;
+    if (!frame->heaviest_name) {
+        return;
+    }
+    int y_offset_text = y_offset + 5;
+    graphics_fill_rect(0, y_offset, 400, 20, COLOR_WHITE);
+    text_draw_number_colored(frame->ticks, 't', "", 5, y_offset_text, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
+    text_draw_number_colored((int) (frame->total_us / 1000),
+        's', "", 40, y_offset_text, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
+    text_draw_number_colored((int) (frame->heaviest_us / 1000),
+        'h', "", 80, y_offset_text, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
+    text_draw_ellipsized((const uint8_t *) frame->heaviest_name,
+        120, y_offset_text, 275, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
+}
+
 static void run_and_draw(void)
 {
     time_millis time_before_run = SDL_GetTicks();
@@ -184,11 +216,17 @@ static void run_and_draw(void)
     game_draw();
     Uint32 time_after_draw = SDL_GetTicks();
 
+    const profiler_frame_summary *frame = game_profiler_get_last_frame();
+    if (frame->total_us > fps.slowest_frame.total_us) {
+        fps.slowest_frame = *frame;
+    }
     fps.frame_count++;
     if (time_after_draw - fps.last_update_time > 1000) {
         fps.last_fps = fps.frame_count;
         fps.last_update_time = time_after_draw;
         fps.frame_count = 0;
+        fps.last_slowest_frame = fps.slowest_frame;
+        memset(&fps.slowest_frame, 0, sizeof(profiler_frame_summary));
     }
     if (window_is(WINDOW_CITY) || window_is(WINDOW_CITY_MILITARY) || window_is(WINDOW_SLIDING_SIDEBAR)) {
         int y_offset = 24;
@@ -200,6 +238,7 @@ static void run_and_draw(void)
             'g', "", 40, y_offset_text, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
         text_draw_number_colored(time_after_draw - time_between_run_and_draw,
             'd', "", 70, y_offset_text, FONT_NORMAL_PLAIN, COLOR_FONT_RED);
+        draw_profiler_summary(y_offset + 20);
     }
     platform_screen_update();
     platform_screen_render();
@@ -276,6 +315,15 @@ static void handle_event(SDL_Event *event)
         case SDL_WINDOWEVENT:
             handle_window_event(&event->window, &data.active);
             break;
+#if SDL_VERSION_ATLEAST(2, 0, 2)
+        case SDL_RENDER_TARGETS_RESET:
+#if SDL_VERSION_ATLEAST(2, 0, 4)
+        case SDL_RENDER_DEVICE_RESET:
+#endif
+            // the contents of the screen texture may be lost
+            platform_screen_invalidate_texture();
+            break;
+#endif
         case SDL_KEYDOWN:
             platform_handle_key_down(&event->key);
             break;
@@ -364,6 +412,13 @@ static void handle_event(SDL_Event *event)
 static void teardown(void)
 {
     SDL_Log("Exiting game");
+    if (data.profile_csv_file) {
+        if (game_profiler_write_csv(data.profile_csv_file)) {
+            SDL_Log("Profiler trace written to %s", data.profile_csv_file);
+        } else {
+            SDL_Log("Unable to write profiler trace to %s", data.profile_csv_file);
+        }
+    }
     game_exit();
     platform_screen_destroy();
     SDL_Quit();
@@ -608,6 +663,13 @@ static void setup(const julius_args *args)
     if (args->cursor_scale_percentage) {
         config_set(CONFIG_SCREEN_CURSOR_SCALE, args->cursor_scale_percentage);
     }
+    if (args->profile_csv_file) {
+        data.profile_csv_file = args->profile_csv_file;
+        game_profiler_set_enabled(1);
+    }
+#ifdef DRAW_FPS
+    game_profiler_set_enabled(1);
+#endif
 
     char title[100];
     encoding_to_utf8(lang_get_string(9, 0), title, 100, 0);
@@ -392,12 +392,47 @@ void platform_screen_clear(void)
     SDL_RenderClear(SDL.renderer);
 }
 
+#ifndef __vita__
+static void update_texture(void)
+{
+    int num_rects;
+    const graphics_dirty_rect *rects = graphics_get_dirty_rects(&num_rects);
+    if (!num_rects) {
+        return;
+    }
+    int width = screen_width();
+    int dirty_area = 0;
+    for (int i = 0; i < num_rects; i++) {
+        dirty_area += (rects[i].x_end - rects[i].x_start) * (rects[i].y_end - rects[i].y_start);
+    }
+    const color_t *canvas = graphics_canvas();
+    if (dirty_area * 2 >= width * screen_height()) {
+        // one upload is cheaper than many that cover most of the screen
+        SDL_UpdateTexture(SDL.texture, NULL, canvas, width * sizeof(color_t));
+        return;
+    }
+    for (int i = 0; i < num_rects; i++) {
+        SDL_Rect rect = {
+            rects[i].x_start, rects[i].y_start,
+            rects[i].x_end - rects[i].x_start, rects[i].y_end - rects[i].y_start
+        };
+        SDL_UpdateTexture(SDL.texture, &rect, &canvas[rect.y * width + rect.x], width * sizeof(color_t));
+    }
+}
+#endif
+
+void platform_screen_invalidate_texture(void)
+{
+    graphics_mark_all_dirty();
+}
+
 void platform_screen_update(void)
 {
     SDL_RenderClear(SDL.renderer);
 #ifndef __vita__
-    SDL_UpdateTexture(SDL.texture, NULL, graphics_canvas(), screen_width() * 4);
+    update_texture();
 #endif
+    graphics_clear_dirty_rects();
     SDL_RenderCopy(SDL.renderer, SDL.texture, NULL, NULL);
 #ifdef PLATFORM_USE_SOFTWARE_CURSOR
     draw_software_mouse_cursor();
@@ -1,5 +1,6 @@
 #include "core/file.h"
 #include "core/log.h"
+#include "sound/channel.h"
 #include "sound/device.h"
 #include "game/settings.h"
 #include "platform/platform.h"
@@ -22,6 +23,9 @@
 
 #define MAX_CHANNELS 150
 
+// Decoded sound effects are kept in memory up to this size
+#define MAX_CHUNK_BYTES (48 * 1024 * 1024)
+
 #if SDL_VERSION_ATLEAST(2, 0, 7)
 #define USE_SDL_AUDIOSTREAM
 #endif
@@ -38,12 +42,25 @@ static struct {
 typedef struct {
     const char *filename;
     Mix_Chunk *chunk;
+    Mix_Chunk *preloaded;
+    int chunk_bytes;
+    unsigned int last_played;
 } sound_channel;
 
 static struct {
     int initialized;
     Mix_Music *music;
     sound_channel channels[MAX_CHANNELS];
+    int num_channels;
+    unsigned int play_count;
+    // Channel chunks are decoded on a background thread after startup. The thread reads the chunks
+    // and sets the preloaded chunks and the byte count, so these are only changed while holding the lock.
+    struct {
+        SDL_Thread *thread;
+        SDL_mutex *lock;
+        SDL_atomic_t cancel;
+        int bytes;
+    } preload;
 } data;
 
 static struct {
@@ -111,17 +128,6 @@ void sound_device_open(void)
     }
 }
 
-void sound_device_close(void)
-{
-    if (data.initialized) {
-        for (int i = 0; i < MAX_CHANNELS; i++) {
-            sound_device_stop_channel(i);
-        }
-        Mix_CloseAudio();
-        data.initialized = 0;
-    }
-}
-
 static Mix_Chunk *load_chunk(const char *filename)
 {
     if (filename[0]) {
@@ -140,11 +146,154 @@ static Mix_Chunk *load_chunk(const char *filename)
     }
 }
 
+static int chunk_bytes(const Mix_Chunk *chunk)
+{
+    return chunk ? (int) chunk->alen : 0;
+}
+
+static void lock_channels(void)
+{
+    if (data.preload.lock) {
+        SDL_LockMutex(data.preload.lock);
+    }
+}
+
+static void unlock_channels(void)
+{
+    if (data.preload.lock) {
+        SDL_UnlockMutex(data.preload.lock);
+    }
+}
+
+static void preload_channel(int index)
+{
+    sound_channel *channel = &data.channels[index];
+    SDL_LockMutex(data.preload.lock);
+    int needs_loading = channel->filename && !channel->chunk && !channel->preloaded &&
+        data.preload.bytes < MAX_CHUNK_BYTES;
+    SDL_UnlockMutex(data.preload.lock);
+    if (!needs_loading) {
+        return;
+    }
+    Mix_Chunk *chunk = load_chunk(channel->filename);
+    SDL_LockMutex(data.preload.lock);
+    if (!channel->chunk && !channel->preloaded) {
+        channel->preloaded = chunk;
+        data.preload.bytes += chunk_bytes(chunk);
+        chunk = 0;
+    }
+    SDL_UnlockMutex(data.preload.lock);
+    if (chunk) {
+        // played, and therefore loaded, while we were decoding
+        Mix_FreeChunk(chunk);
+    }
+}
+
+static int preload_channels(void *unused)
+{
+    // interface effects first: they play on a click, city sounds can start a bit later
+    for (int i = SOUND_CHANNEL_EFFECTS_MIN; i < data.num_channels && !SDL_AtomicGet(&data.preload.cancel); i++) {
+        preload_channel(i);
+    }
+    return 0;
+}
+
+static void start_preloading(void)
+{
+    if (!data.preload.lock) {
+        data.preload.lock = SDL_CreateMutex();
+        if (!data.preload.lock) {
+            SDL_Log("Unable to preload sounds: %s", SDL_GetError());
+            return;
+        }
+    }
+    SDL_AtomicSet(&data.preload.cancel, 0);
+    data.preload.thread = SDL_CreateThread(preload_channels, "sound preload", 0);
+    if (!data.preload.thread) {
+        SDL_Log("Unable to preload sounds: %s", SDL_GetError());
+    }
+}
+
+static void stop_preloading(void)
+{
+    if (data.preload.thread) {
+        SDL_AtomicSet(&data.preload.cancel, 1);
+        SDL_WaitThread(data.preload.thread, 0);
+        data.preload.thread = 0;
+    }
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        if (data.channels[i].preloaded) {
+            data.preload.bytes -= chunk_bytes(data.channels[i].preloaded);
+            Mix_FreeChunk(data.channels[i].preloaded);
+            data.channels[i].preloaded = 0;
+        }
+    }
+}
+
+static void free_channel_chunk(sound_channel *channel)
+{
+    lock_channels();
+    Mix_Chunk *chunk = channel->chunk;
+    data.preload.bytes -= channel->chunk_bytes;
+    channel->chunk = 0;
+    channel->chunk_bytes = 0;
+    unlock_channels();
+    Mix_FreeChunk(chunk);
+}
+
+static int is_over_memory_budget(void)
+{
+    lock_channels();
+    int over_budget = data.preload.bytes > MAX_CHUNK_BYTES;
+    unlock_channels();
+    return over_budget;
+}
+
+// Only chunks that have been played are evicted, the preloader itself stops at the budget
+static void evict_chunks(const sound_channel *keep)
+{
+    while (is_over_memory_budget()) {
+        int oldest = -1;
+        for (int i = 0; i < data.num_channels; i++) {
+            sound_channel *channel = &data.channels[i];
+            if (channel != keep && channel->chunk_bytes && !Mix_Playing(i) &&
+                (oldest < 0 || channel->last_played < data.channels[oldest].last_played)) {
+                oldest = i;
+            }
+        }
+        if (oldest < 0) {
+            return;
+        }
+        free_channel_chunk(&data.channels[oldest]);
+    }
+}
+
 static int load_channel(sound_channel *channel)
 {
     if (!channel->chunk && channel->filename) {
-        channel->chunk = load_chunk(channel->filename);
+        lock_channels();
+        channel->chunk = channel->preloaded;
+        channel->chunk_bytes = chunk_bytes(channel->preloaded);
+        channel->preloaded = 0;
+        unlock_channels();
+        if (!channel->chunk) {
+            // not preloaded yet, or evicted
+            Mix_Chunk *chunk = load_chunk(channel->filename);
+            lock_channels();
+            // the preloader may have finished the same chunk while we were decoding
+            Mix_Chunk *preloaded = channel->preloaded;
+            data.preload.bytes += chunk_bytes(chunk) - chunk_bytes(preloaded);
+            channel->preloaded = 0;
+            channel->chunk = chunk;
+            channel->chunk_bytes = chunk_bytes(chunk);
+            unlock_channels();
+            if (preloaded) {
+                Mix_FreeChunk(preloaded);
+            }
+        }
+        evict_chunks(channel);
     }
+    channel->last_played = ++data.play_count;
     return channel->chunk ? 1 : 0;
 }
 
@@ -154,12 +303,28 @@ void sound_device_init_channels(int num_channels, char filenames[][CHANNEL_FILEN
         if (num_channels > MAX_CHANNELS) {
             num_channels = MAX_CHANNELS;
         }
+        stop_preloading();
         Mix_AllocateChannels(num_channels);
         log_info("Loading audio files", 0, 0);
         for (int i = 0; i < num_channels; i++) {
             data.channels[i].chunk = 0;
+            data.channels[i].chunk_bytes = 0;
             data.channels[i].filename = filenames[i][0] ? filenames[i] : 0;
         }
+        data.num_channels = num_channels;
+        start_preloading();
+    }
+}
+
+void sound_device_close(void)
+{
+    if (data.initialized) {
+        stop_preloading();
+        for (int i = 0; i < MAX_CHANNELS; i++) {
+            sound_device_stop_channel(i);
+        }
+        Mix_CloseAudio();
+        data.initialized = 0;
     }
 }
 
@@ -248,7 +413,10 @@ void sound_device_play_file_on_channel(const char *filename, int channel, int vo
 {
     if (data.initialized) {
         sound_device_stop_channel(channel);
-        data.channels[channel].chunk = load_chunk(filename);
+        Mix_Chunk *chunk = load_chunk(filename);
+        lock_channels();
+        data.channels[channel].chunk = chunk;
+        unlock_channels();
         if (data.channels[channel].chunk) {
             sound_device_set_channel_volume(channel, volume_pct);
             Mix_PlayChannel(channel, data.channels[channel].chunk, 0);
@@ -296,8 +464,7 @@ void sound_device_stop_channel(int channel)
         sound_channel *ch = &data.channels[channel];
         if (ch->chunk) {
             Mix_HaltChannel(channel);
-            Mix_FreeChunk(ch->chunk);
-            ch->chunk = 0;
+            free_channel_chunk(ch);
         }
     }
 }
@@ -0,0 +1,134 @@
+#include "game/system.h"
+
+#include "SDL.h"
+
+#define MAX_WORKERS 8
+
+static struct {
+    SDL_Thread *thread;
+    SDL_atomic_t running;
+    void (*task)(void *data);
+    void *data;
+} background;
+
+static struct {
+    int initialized;
+    int num_workers;
+    SDL_mutex *lock;
+    SDL_sem *start;
+    SDL_sem *done;
+    struct {
+        system_task_func task;
+        void *data;
+        int count;
+        SDL_atomic_t next_index;
+    } job;
+} data;
+
+static void run_tasks(void)
+{
+    int index;
+    while ((index = SDL_AtomicAdd(&data.job.next_index, 1)) < data.job.count) {
+        data.job.task(data.job.data, index);
+    }
+}
+
+static int worker(void *unused)
+{
+    while (1) {
+        SDL_SemWait(data.start);
+        run_tasks();
+        SDL_SemPost(data.done);
+    }
+    return 0;
+}
+
+static void init_workers(void)
+{
+    data.initialized = 1;
+    int num_workers = SDL_GetCPUCount() - 1;
+    if (num_workers > MAX_WORKERS) {
+        num_workers = MAX_WORKERS;
+    }
+    if (num_workers <= 0) {
+        return;
+    }
+    data.lock = SDL_CreateMutex();
+    data.start = SDL_CreateSemaphore(0);
+    data.done = SDL_CreateSemaphore(0);
+    if (!data.lock || !data.start || !data.done) {
+        SDL_Log("Unable to create worker threads: %s", SDL_GetError());
+        return;
+    }
+    for (int i = 0; i < num_workers; i++) {
+        SDL_Thread *thread = SDL_CreateThread(worker, "worker", 0);
+        if (!thread) {
+            SDL_Log("Unable to create worker thread: %s", SDL_GetError());
+            break;
+        }
+        SDL_DetachThread(thread);
+        data.num_workers++;
+    }
+    SDL_Log("Using %d worker threads", data.num_workers);
+}
+
+void system_run_parallel(system_task_func task, void *task_data, int count)
+{
+    if (!data.initialized) {
+        init_workers();
+    }
+    if (count <= 1 || !data.num_workers) {
+        for (int i = 0; i < count; i++) {
+            task(task_data, i);
+        }
+        return;
+    }
+    SDL_LockMutex(data.lock);
+    data.job.task = task;
+    data.job.data = task_data;
+    data.job.count = count;
+    SDL_AtomicSet(&data.job.next_index, 0);
+
+    int num_helpers = count - 1 < data.num_workers ? count - 1 : data.num_workers;
+    for (int i = 0; i < num_helpers; i++) {
+        SDL_SemPost(data.start);
+    }
+    run_tasks();
+    for (int i = 0; i < num_helpers; i++) {
+        SDL_SemWait(data.done);
+    }
+    SDL_UnlockMutex(data.lock);
+}
+
+static int run_background_task(void *unused)
+{
+    background.task(background.data);
+    SDL_AtomicSet(&background.running, 0);
+    return 0;
+}
+
+void system_run_in_background(void (*task)(void *data), void *task_data)
+{
+    system_wait_for_background_task();
+    background.task = task;
+    background.data = task_data;
+    SDL_AtomicSet(&background.running, 1);
+    background.thread = SDL_CreateThread(run_background_task, "background", 0);
+    if (!background.thread) {
+        SDL_Log("Unable to create background thread, running task directly: %s", SDL_GetError());
+        run_background_task(0);
+    }
+}
+
+int system_background_task_running(void)
+{
+    return SDL_AtomicGet(&background.running);
+}
+
+void system_wait_for_background_task(void)
+{
+    if (background.thread) {
+        SDL_WaitThread(background.thread, 0);
+        background.thread = 0;
+    }
+}
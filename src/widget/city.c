@@ -43,6 +43,8 @@ static void set_city_clip_rectangle(void)
     int x, y, width, height;
     city_view_get_viewport(&x, &y, &width, &height);
     graphics_set_clip_rectangle(x, y, width, height);
+    // the whole city is redrawn, marking it at once saves merging every tile into the dirty rectangles
+    graphics_mark_dirty(x, y, width, height);
 }
 
 void widget_city_draw(void)
@@ -10,9 +10,12 @@
 #include "city/ratings.h"
 #include "city/view.h"
 #include "core/config.h"
+#include "core/log.h"
 #include "core/time.h"
 #include "figure/formation_legion.h"
 #include "game/resource.h"
+#include "game/system.h"
+#include "graphics/graphics.h"
 #include "graphics/image.h"
 #include "graphics/window.h"
 #include "map/building.h"
@@ -22,13 +25,26 @@
 #include "map/property.h"
 #include "map/sprite.h"
 #include "map/terrain.h"
+#include "scenario/property.h"
 #include "sound/city.h"
 #include "widget/city_bridge.h"
 #include "widget/city_building_ghost.h"
 #include "widget/city_figure.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #define OFFSET(x,y) (x + GRID_SIZE * y)
 
+#define MIN_BAND_HEIGHT 120
+#ifndef MAX_BANDS
+#define MAX_BANDS 16
+#endif
+#ifndef USE_GROUND_CACHE
+#define USE_GROUND_CACHE 1
+#endif
+#define MAX_GROUND_REDRAWS 512
+
 static const int ADJACENT_OFFSETS[2][4][7] = {
     {
         {OFFSET(-1, 0), OFFSET(-1, -1),  OFFSET(-1, -2), OFFSET(0, -2), OFFSET(1, -2)},
@@ -53,8 +69,45 @@ static struct {
     int selected_figure_id;
     int highlighted_formation;
     pixel_coordinate *selected_figure_coord;
+    grid_u8 animation_offsets;
+    int use_ground_cache;
+    const view_draw_list *draw_list;
 } draw_context;
 
+// Footprints only change on construction, so they are kept in a viewport-sized buffer between frames.
+// Animated water changes all the time, it is drawn over the buffer instead.
+static struct {
+    color_t *pixels;
+    int x;
+    int y;
+    int width;
+    int height;
+    int camera_tile_x;
+    int camera_tile_y;
+    int camera_pixel_x;
+    int camera_pixel_y;
+    int orientation;
+    scenario_climate climate;
+    int lookup_version;
+    int is_valid;
+    grid_u16 footprint_keys;
+    struct {
+        int x;
+        int y;
+        int grid_offset;
+    } redraws[MAX_GROUND_REDRAWS];
+    int num_redraws;
+} ground;
+
+typedef struct {
+    void (*draw)(int y_start, int y_end);
+    int x;
+    int y;
+    int width;
+    int height;
+    int num_bands;
+} band_job;
+
 static void init_draw_context(int selected_figure_id, pixel_coordinate *figure_coord, int highlighted_formation)
 {
     draw_context.advance_water_animation = 0;
@@ -97,49 +150,120 @@ static int has_adjacent_deletion(int grid_offset)
     return 0;
 }
 
-static void draw_footprint(int x, int y, int grid_offset)
+static int footprint_image(int grid_offset, color_t *color_mask)
+{
+    *color_mask = 0;
+    if (draw_building_as_deleted(building_get(map_building_at(grid_offset)))) {
+        *color_mask = COLOR_MASK_RED;
+    }
+    if (map_property_is_constructing(grid_offset)) {
+        return image_group(GROUP_TERRAIN_OVERLAY);
+    }
+    return map_image_at(grid_offset);
+}
+
+static int is_animated_water(int grid_offset)
+{
+    int image_id = map_image_at(grid_offset);
+    return image_id >= draw_context.image_id_water_first && image_id <= draw_context.image_id_water_last &&
+        !map_property_is_constructing(grid_offset);
+}
+
+static void update_ground_key(int x, int y, int grid_offset)
+{
+    color_t color_mask = 0;
+    int key = 0;
+    if (map_property_is_draw_tile(grid_offset)) {
+        // every frame of the water gets the same key, the water is not taken from the buffer
+        key = is_animated_water(grid_offset) ?
+            draw_context.image_id_water_first + 1 : footprint_image(grid_offset, &color_mask) + 1;
+    }
+    if (key && color_mask) {
+        key |= 0x8000;
+    }
+    if (ground.footprint_keys.items[grid_offset] == key) {
+        return;
+    }
+    ground.footprint_keys.items[grid_offset] = key;
+    if (!key || !ground.is_valid) {
+        return;
+    }
+    if (ground.num_redraws >= MAX_GROUND_REDRAWS) {
+        ground.is_valid = 0;
+        return;
+    }
+    ground.redraws[ground.num_redraws].x = x;
+    ground.redraws[ground.num_redraws].y = y;
+    ground.redraws[ground.num_redraws].grid_offset = grid_offset;
+    ground.num_redraws++;
+}
+
+static void update_footprint(int x, int y, int grid_offset)
 {
     building_construction_record_view_position(x, y, grid_offset);
     if (grid_offset < 0) {
-        // Outside map: draw black tile
-        image_draw_isometric_footprint_from_draw_tile(image_group(GROUP_TERRAIN_BLACK), x, y, 0);
-    } else if (map_property_is_draw_tile(grid_offset)) {
-        // Valid grid_offset and leftmost tile -> draw
-        int building_id = map_building_at(grid_offset);
-        color_t color_mask = 0;
-        if (building_id) {
-            building *b = building_get(building_id);
-            if (draw_building_as_deleted(b)) {
-                color_mask = COLOR_MASK_RED;
-            }
-            int view_x, view_y, view_width, view_height;
-            city_view_get_viewport(&view_x, &view_y, &view_width, &view_height);
-            if (x < view_x + 100) {
-                sound_city_mark_building_view(b, SOUND_DIRECTION_LEFT);
-            } else if (x > view_x + view_width - 100) {
-                sound_city_mark_building_view(b, SOUND_DIRECTION_RIGHT);
-            } else {
-                sound_city_mark_building_view(b, SOUND_DIRECTION_CENTER);
-            }
-        }
-        if (map_terrain_is(grid_offset, TERRAIN_GARDEN)) {
-            building *b = building_get(0); // abuse empty building
-            b->type = BUILDING_GARDENS;
+        return;
+    }
+    if (!map_property_is_draw_tile(grid_offset)) {
+        update_ground_key(x, y, grid_offset);
+        return;
+    }
+    int building_id = map_building_at(grid_offset);
+    if (building_id) {
+        building *b = building_get(building_id);
+        int view_x, view_y, view_width, view_height;
+        city_view_get_viewport(&view_x, &view_y, &view_width, &view_height);
+        if (x < view_x + 100) {
+            sound_city_mark_building_view(b, SOUND_DIRECTION_LEFT);
+        } else if (x > view_x + view_width - 100) {
+            sound_city_mark_building_view(b, SOUND_DIRECTION_RIGHT);
+        } else {
             sound_city_mark_building_view(b, SOUND_DIRECTION_CENTER);
         }
-        int image_id = map_image_at(grid_offset);
-        if (map_property_is_constructing(grid_offset)) {
-            image_id = image_group(GROUP_TERRAIN_OVERLAY);
+    }
+    if (map_terrain_is(grid_offset, TERRAIN_GARDEN)) {
+        building *b = building_get(0); // abuse empty building
+        b->type = BUILDING_GARDENS;
+        sound_city_mark_building_view(b, SOUND_DIRECTION_CENTER);
+    }
+    int image_id = map_image_at(grid_offset);
+    if (!map_property_is_constructing(grid_offset) &&
+        draw_context.advance_water_animation &&
+        image_id >= draw_context.image_id_water_first &&
+        image_id <= draw_context.image_id_water_last) {
+        image_id++;
+        if (image_id > draw_context.image_id_water_last) {
+            image_id = draw_context.image_id_water_first;
         }
-        if (draw_context.advance_water_animation &&
-            image_id >= draw_context.image_id_water_first &&
-            image_id <= draw_context.image_id_water_last) {
-            image_id++;
-            if (image_id > draw_context.image_id_water_last) {
-                image_id = draw_context.image_id_water_first;
-            }
-            map_image_set(grid_offset, image_id);
+        map_image_set(grid_offset, image_id);
+    }
+    update_ground_key(x, y, grid_offset);
+}
+
+static void update_animation(int x, int y, int grid_offset)
+{
+    int image_id = map_image_at(grid_offset);
+    const image *img = image_get(image_id);
+    if (img->num_animation_sprites) {
+        if (map_property_is_draw_tile(grid_offset)) {
+            building *b = building_get(map_building_at(grid_offset));
+            draw_context.animation_offsets.items[grid_offset] = building_animation_offset(b, image_id, grid_offset);
         }
+    } else if (map_sprite_bridge_at(grid_offset) && !map_terrain_is(grid_offset, TERRAIN_WATER)) {
+        // leftover bridge sprite, city_draw_bridge would clear it
+        map_sprite_clear_tile(grid_offset);
+    }
+}
+
+static void draw_footprint(int x, int y, int grid_offset)
+{
+    if (grid_offset < 0) {
+        // Outside map: draw black tile
+        image_draw_isometric_footprint_from_draw_tile(image_group(GROUP_TERRAIN_BLACK), x, y, 0);
+    } else if (map_property_is_draw_tile(grid_offset)) {
+        // Valid grid_offset and leftmost tile -> draw
+        color_t color_mask;
+        int image_id = footprint_image(grid_offset, &color_mask);
         image_draw_isometric_footprint_from_draw_tile(image_id, x, y, color_mask);
     }
 }
@@ -379,7 +503,7 @@ static void draw_animation(int x, int y, int grid_offset)
             } else if (b->type == BUILDING_BURNING_RUIN && b->ruin_has_plague) {
                 image_draw_masked(image_group(GROUP_PLAGUE_SKULL), x + 18, y - 32, color_mask);
             }
-            int animation_offset = building_animation_offset(b, image_id, grid_offset);
+            int animation_offset = draw_context.animation_offsets.items[grid_offset];
             if (b->type != BUILDING_HIPPODROME && animation_offset > 0) {
                 if (animation_offset > img->num_animation_sprites) {
                     animation_offset = img->num_animation_sprites;
@@ -502,6 +626,292 @@ static void deletion_draw_remaining(int x, int y, int grid_offset)
     draw_hippodrome_ornaments(x, y, grid_offset);
 }
 
+static void draw_footprint_rows(int y_start, int y_end)
+{
+    const view_draw_list *list = draw_context.draw_list;
+    int first_row, end_row;
+    city_view_get_draw_rows_in_band(list, y_start, y_end, &first_row, &end_row);
+    if (first_row == end_row) {
+        return;
+    }
+    const view_draw_tile *tile = &list->tiles[list->rows[first_row].first_tile];
+    const view_draw_row *last = &list->rows[end_row - 1];
+    const view_draw_tile *end = &list->tiles[last->first_tile + last->num_tiles];
+    for (; tile < end; tile++) {
+        draw_footprint(tile->x, tile->y, tile->grid_offset);
+    }
+}
+
+static void draw_animated_water_rows(int y_start, int y_end)
+{
+    const view_draw_list *list = draw_context.draw_list;
+    int first_row, end_row;
+    city_view_get_draw_rows_in_band(list, y_start, y_end, &first_row, &end_row);
+    if (first_row == end_row) {
+        return;
+    }
+    const view_draw_tile *tile = &list->valid_tiles[list->rows[first_row].first_valid_tile];
+    const view_draw_row *last = &list->rows[end_row - 1];
+    const view_draw_tile *end = &list->valid_tiles[last->first_valid_tile + last->num_valid_tiles];
+    for (; tile < end; tile++) {
+        if (is_animated_water(tile->grid_offset)) {
+            draw_footprint(tile->x, tile->y, tile->grid_offset);
+        }
+    }
+}
+
+static void draw_footprints(int y_start, int y_end)
+{
+    if (draw_context.use_ground_cache) {
+        for (int y = y_start; y < y_end; y++) {
+            memcpy(graphics_get_pixel(ground.x, y), &ground.pixels[(y - ground.y) * ground.width],
+                ground.width * sizeof(color_t));
+        }
+        // water tiles are single diamonds that no other footprint overlaps, so drawing them last is the same
+        draw_animated_water_rows(y_start, y_end);
+    } else {
+        draw_footprint_rows(y_start, y_end);
+    }
+}
+
+static void draw_ground_buildings_figures(int y_start, int y_end)
+{
+    draw_footprints(y_start, y_end);
+    const view_draw_list *list = draw_context.draw_list;
+    int first_row, end_row;
+    city_view_get_draw_rows_in_band(list, y_start, y_end, &first_row, &end_row);
+    for (int r = first_row; r < end_row; r++) {
+        const view_draw_tile *tiles = &list->valid_tiles[list->rows[r].first_valid_tile];
+        int num_tiles = list->rows[r].num_valid_tiles;
+        for (int i = 0; i < num_tiles; i++) {
+            draw_top(tiles[i].x, tiles[i].y, tiles[i].grid_offset);
+        }
+        for (int i = 0; i < num_tiles; i++) {
+            draw_figures(tiles[i].x, tiles[i].y, tiles[i].grid_offset);
+        }
+        for (int i = 0; i < num_tiles; i++) {
+            draw_animation(tiles[i].x, tiles[i].y, tiles[i].grid_offset);
+        }
+    }
+}
+
+static void draw_elevated(int y_start, int y_end)
+{
+    const view_draw_list *list = draw_context.draw_list;
+    int first_row, end_row;
+    city_view_get_draw_rows_in_band(list, y_start, y_end, &first_row, &end_row);
+    for (int r = first_row; r < end_row; r++) {
+        const view_draw_tile *tiles = &list->valid_tiles[list->rows[r].first_valid_tile];
+        int num_tiles = list->rows[r].num_valid_tiles;
+        for (int i = 0; i < num_tiles; i++) {
+            draw_elevated_figures(tiles[i].x, tiles[i].y, tiles[i].grid_offset);
+        }
+        for (int i = 0; i < num_tiles; i++) {
+            draw_hippodrome_ornaments(tiles[i].x, tiles[i].y, tiles[i].grid_offset);
+        }
+    }
+}
+
+static void draw_with_deletion(int y_start, int y_end)
+{
+    draw_footprints(y_start, y_end);
+    const view_draw_list *list = draw_context.draw_list;
+    int first_row, end_row;
+    city_view_get_draw_rows_in_band(list, y_start, y_end, &first_row, &end_row);
+    if (first_row == end_row) {
+        return;
+    }
+    // every pass goes over the whole band, the valid tiles of consecutive rows are contiguous
+    const view_draw_tile *start = &list->valid_tiles[list->rows[first_row].first_valid_tile];
+    const view_draw_row *last = &list->rows[end_row - 1];
+    const view_draw_tile *end = &list->valid_tiles[last->first_valid_tile + last->num_valid_tiles];
+    for (const view_draw_tile *tile = start; tile < end; tile++) {
+        deletion_draw_terrain_top(tile->x, tile->y, tile->grid_offset);
+    }
+    for (const view_draw_tile *tile = start; tile < end; tile++) {
+        deletion_draw_figures_animations(tile->x, tile->y, tile->grid_offset);
+    }
+    for (const view_draw_tile *tile = start; tile < end; tile++) {
+        deletion_draw_remaining(tile->x, tile->y, tile->grid_offset);
+    }
+}
+
+static void draw_band(void *data, int index)
+{
+    const band_job *job = data;
+    int y_start = job->y + job->height * index / job->num_bands;
+    int y_end = job->y + job->height * (index + 1) / job->num_bands;
+    graphics_set_clip_rectangle(job->x, y_start, job->width, y_end - y_start);
+    job->draw(y_start, y_end);
+}
+
+static void draw_in_bands(void (*draw)(int y_start, int y_end), int allow_parallel)
+{
+    band_job job;
+    job.draw = draw;
+    city_view_get_viewport(&job.x, &job.y, &job.width, &job.height);
+    job.num_bands = allow_parallel ? job.height / MIN_BAND_HEIGHT : 1;
+    if (job.num_bands <= 1) {
+        // the clip rectangle is already set to the viewport
+        draw(job.y, job.y + job.height);
+        return;
+    }
+    if (job.num_bands > MAX_BANDS) {
+        job.num_bands = MAX_BANDS;
+    }
+    // every band draws all tiles that reach into it, clipped to the band, so the result is the same
+    // as drawing the viewport at once. The viewport has already been marked as dirty.
+    graphics_set_dirty_tracking(0);
+    system_run_parallel(draw_band, &job, job.num_bands);
+    graphics_set_dirty_tracking(1);
+    graphics_set_clip_rectangle(job.x, job.y, job.width, job.height);
+}
+
+static void prepare_ground_cache(void)
+{
+    int x, y, width, height;
+    city_view_get_viewport(&x, &y, &width, &height);
+    if (!ground.pixels || ground.width != width || ground.height != height) {
+        free(ground.pixels);
+        ground.pixels = malloc((size_t) width * height * sizeof(color_t));
+        ground.is_valid = 0;
+        if (!ground.pixels) {
+            log_error("Unable to allocate ground cache, size", 0, width * height);
+            ground.width = ground.height = 0;
+            return;
+        }
+        ground.width = width;
+        ground.height = height;
+    }
+    int tile_x, tile_y, pixel_x, pixel_y;
+    city_view_get_camera(&tile_x, &tile_y);
+    city_view_get_pixel_offset(&pixel_x, &pixel_y);
+    if (ground.x != x || ground.y != y || ground.orientation != city_view_orientation() ||
+        ground.climate != scenario_property_climate() || ground.lookup_version != city_view_lookup_version() ||
+        (tile_y - ground.camera_tile_y) % 2) {
+        // odd view rows are shifted half a tile, so only a camera move of whole rows can be scrolled
+        ground.is_valid = 0;
+    }
+    ground.x = x;
+    ground.y = y;
+    ground.orientation = city_view_orientation();
+    ground.climate = scenario_property_climate();
+    ground.lookup_version = city_view_lookup_version();
+    ground.num_redraws = 0;
+}
+
+static void copy_to_ground_cache(int x, int y, int width, int height)
+{
+    for (int yy = y; yy < y + height; yy++) {
+        memcpy(&ground.pixels[(yy - ground.y) * ground.width + x - ground.x], graphics_get_pixel(x, yy),
+            width * sizeof(color_t));
+    }
+}
+
+static void copy_from_ground_cache(int x, int y, int width, int height)
+{
+    for (int yy = y; yy < y + height; yy++) {
+        memcpy(graphics_get_pixel(x, yy), &ground.pixels[(yy - ground.y) * ground.width + x - ground.x],
+            width * sizeof(color_t));
+    }
+}
+
+static void scroll_ground_cache(int dx, int dy)
+{
+    int width = ground.width - abs(dx);
+    int height = ground.height - abs(dy);
+    int src_x = dx > 0 ? dx : 0;
+    int dst_x = dx > 0 ? 0 : -dx;
+    for (int i = 0; i < height; i++) {
+        // go against the scroll direction so rows are read before they are overwritten
+        int row = dy >= 0 ? i : height - 1 - i;
+        int src_y = dy > 0 ? row + dy : row;
+        int dst_y = dy > 0 ? row : row - dy;
+        memmove(&ground.pixels[dst_y * ground.width + dst_x], &ground.pixels[src_y * ground.width + src_x],
+            width * sizeof(color_t));
+    }
+}
+
+static void redraw_ground_area(int x, int y, int width, int height)
+{
+    graphics_set_clip_rectangle(x, y, width, height);
+    draw_footprint_rows(y, y + height);
+    copy_to_ground_cache(x, y, width, height);
+}
+
+static void redraw_ground_tile(int x, int y, int grid_offset)
+{
+    color_t color_mask;
+    const image *img = image_get(footprint_image(grid_offset, &color_mask));
+    int size = (img->width + 2) / 60;
+    if (size < 1) {
+        return;
+    }
+    int x_start = x;
+    int y_start = y - 15 * (size - 1);
+    int x_end = x + img->width;
+    int y_end = y_start + 30 * size;
+    if (x_start < ground.x) {
+        x_start = ground.x;
+    }
+    if (y_start < ground.y) {
+        y_start = ground.y;
+    }
+    if (x_end > ground.x + ground.width) {
+        x_end = ground.x + ground.width;
+    }
+    if (y_end > ground.y + ground.height) {
+        y_end = ground.y + ground.height;
+    }
+    if (x_start >= x_end || y_start >= y_end) {
+        return;
+    }
+    // the footprint only covers its own diamonds, the corners of the area belong to other tiles
+    copy_from_ground_cache(x_start, y_start, x_end - x_start, y_end - y_start);
+    graphics_set_clip_rectangle(x_start, y_start, x_end - x_start, y_end - y_start);
+    draw_footprint(x, y, grid_offset);
+    copy_to_ground_cache(x_start, y_start, x_end - x_start, y_end - y_start);
+}
+
+static void update_ground_cache(void)
+{
+    int tile_x, tile_y, pixel_x, pixel_y;
+    city_view_get_camera(&tile_x, &tile_y);
+    city_view_get_pixel_offset(&pixel_x, &pixel_y);
+    int dx = (tile_x - ground.camera_tile_x) * 60 + pixel_x - ground.camera_pixel_x;
+    int dy = (tile_y - ground.camera_tile_y) * 15 + pixel_y - ground.camera_pixel_y;
+    ground.camera_tile_x = tile_x;
+    ground.camera_tile_y = tile_y;
+    ground.camera_pixel_x = pixel_x;
+    ground.camera_pixel_y = pixel_y;
+    if (abs(dx) >= ground.width || abs(dy) >= ground.height) {
+        ground.is_valid = 0;
+    }
+    if (!ground.is_valid) {
+        draw_in_bands(draw_footprints, 1);
+        copy_to_ground_cache(ground.x, ground.y, ground.width, ground.height);
+        ground.is_valid = 1;
+        return;
+    }
+    if (dx || dy) {
+        scroll_ground_cache(dx, dy);
+        if (dy > 0) {
+            redraw_ground_area(ground.x, ground.y + ground.height - dy, ground.width, dy);
+        } else if (dy < 0) {
+            redraw_ground_area(ground.x, ground.y, ground.width, -dy);
+        }
+        if (dx > 0) {
+            redraw_ground_area(ground.x + ground.width - dx, ground.y, dx, ground.height);
+        } else if (dx < 0) {
+            redraw_ground_area(ground.x, ground.y, -dx, ground.height);
+        }
+    }
+    for (int i = 0; i < ground.num_redraws; i++) {
+        redraw_ground_tile(ground.redraws[i].x, ground.redraws[i].y, ground.redraws[i].grid_offset);
+    }
+    graphics_set_clip_rectangle(ground.x, ground.y, ground.width, ground.height);
+}
+
 void city_without_overlay_draw(int selected_figure_id, pixel_coordinate *figure_coord, const map_tile *tile)
 {
     int highlighted_formation = 0;
@@ -518,25 +928,35 @@ void city_without_overlay_draw(int selected_figure_id, pixel_coordinate *figure_
         }
     }
     init_draw_context(selected_figure_id, figure_coord, highlighted_formation);
+    const view_draw_list *list = city_view_get_draw_list();
+    draw_context.draw_list = list;
     int should_mark_deleting = city_building_ghost_mark_deleting(tile);
-    city_view_foreach_map_tile(draw_footprint);
+
+    // everything that changes state runs once, before the tiles are drawn
+    draw_context.use_ground_cache = 0;
+    if (USE_GROUND_CACHE) {
+        prepare_ground_cache();
+    }
+    for (int i = 0; i < list->num_tiles; i++) {
+        update_footprint(list->tiles[i].x, list->tiles[i].y, list->tiles[i].grid_offset);
+    }
+    for (int i = 0; i < list->num_valid_tiles; i++) {
+        update_animation(list->valid_tiles[i].x, list->valid_tiles[i].y, list->valid_tiles[i].grid_offset);
+    }
+    if (USE_GROUND_CACHE && ground.pixels) {
+        update_ground_cache();
+        draw_context.use_ground_cache = 1;
+    }
+
+    // the selected figure reports its position while being drawn, so keep that on one thread
+    int allow_parallel = !selected_figure_id;
     if (!should_mark_deleting) {
-        city_view_foreach_valid_map_tile_row(
-            draw_top,
-            draw_figures,
-            draw_animation
-        );
+        draw_in_bands(draw_ground_buildings_figures, allow_parallel);
         if (!selected_figure_id) {
             city_building_ghost_draw(tile);
         }
-        city_view_foreach_valid_map_tile_row(
-            draw_elevated_figures,
-            draw_hippodrome_ornaments,
-            0
-        );
+        draw_in_bands(draw_elevated, allow_parallel);
     } else {
-        city_view_foreach_valid_map_tile(deletion_draw_terrain_top);
-        city_view_foreach_valid_map_tile(deletion_draw_figures_animations);
-        city_view_foreach_valid_map_tile(deletion_draw_remaining);
+        draw_in_bands(draw_with_deletion, allow_parallel);
     }
 }
@@ -119,7 +119,8 @@ static config_widget all_widgets[MAX_WIDGETS] = {
     {TYPE_SPACE},
     {TYPE_HEADER, 0, TR_CONFIG_HEADER_GAMEPLAY_CHANGES},
     {TYPE_CHECKBOX, CONFIG_GP_FIX_IMMIGRATION_BUG, TR_CONFIG_FIX_IMMIGRATION_BUG},
-    {TYPE_CHECKBOX, CONFIG_GP_FIX_100_YEAR_GHOSTS, TR_CONFIG_FIX_100_YEAR_GHOSTS}
+    {TYPE_CHECKBOX, CONFIG_GP_FIX_100_YEAR_GHOSTS, TR_CONFIG_FIX_100_YEAR_GHOSTS},
+    {TYPE_CHECKBOX, CONFIG_GP_FIX_ROUTE_LIMIT, TR_CONFIG_FIX_ROUTE_LIMIT}
 };
 
 static generic_button select_buttons[] = {
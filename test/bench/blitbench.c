@@ -0,0 +1,148 @@
+#include "game/system.h"
+#include "graphics/blit.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_PIXELS (256 * 1024)
+#define MAX_ROW_LENGTH 300
+
+typedef enum {
+    KERNEL_MASKED_COPY,
+    KERNEL_MASKED_SET,
+    KERNEL_MASKED_AND,
+    KERNEL_MASKED_BLEND,
+    KERNEL_AND,
+    KERNEL_MIX,
+    KERNEL_CONVERT_555,
+    KERNEL_MAX
+} kernel;
+
+static const char *kernel_names[KERNEL_MAX] = {"masked copy", "masked set", "masked and", "masked blend", "and", "mix", "convert 555"};
+
+static color_t source[NUM_PIXELS];
+static color_t background[NUM_PIXELS];
+static color_t expected[KERNEL_MAX][NUM_PIXELS];
+static color_t actual[NUM_PIXELS];
+static int row_lengths[NUM_PIXELS];
+static int num_rows;
+
+static uint32_t random_state = 12345;
+
+static uint32_t next_random(void)
+{
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 8;
+}
+
+static void generate_pixels(void)
+{
+    // runs of transparent and opaque pixels, like sprites have
+    int i = 0;
+    while (i < NUM_PIXELS) {
+        int run = 1 + next_random() % 24;
+        int transparent = next_random() % 3 == 0;
+        for (; run > 0 && i < NUM_PIXELS; run--, i++) {
+            source[i] = transparent ? COLOR_SG2_TRANSPARENT : next_random();
+            background[i] = next_random();
+        }
+    }
+    // row lengths of every size, so the scalar tails of the SIMD kernels are covered too
+    int total = 0;
+    num_rows = 0;
+    while (total < NUM_PIXELS) {
+        int length = 1 + next_random() % MAX_ROW_LENGTH;
+        if (total + length > NUM_PIXELS) {
+            length = NUM_PIXELS - total;
+        }
+        row_lengths[num_rows++] = length;
+        total += length;
+    }
+}
+
+static void run_kernel(kernel k, color_t *dst)
+{
+    static const color_t colors[] = {0xc03c80e0, 0x80ff0000, 0x01000000, 0xfe00ff00, 0x7f123456};
+    const color_t *src = source;
+    for (int row = 0; row < num_rows; row++) {
+        int length = row_lengths[row];
+        color_t color = colors[row % 5];
+        switch (k) {
+            case KERNEL_MASKED_COPY:
+                blit_masked_copy(dst, src, length);
+                break;
+            case KERNEL_MASKED_SET:
+                blit_masked_set(dst, src, length, color);
+                break;
+            case KERNEL_MASKED_AND:
+                blit_masked_and(dst, src, length, color);
+                break;
+            case KERNEL_MASKED_BLEND:
+                blit_masked_blend(dst, src, length, color);
+                break;
+            case KERNEL_AND:
+                blit_and(dst, src, length, color);
+                break;
+            case KERNEL_MIX:
+                blit_mix(dst, length, color);
+                break;
+            case KERNEL_CONVERT_555:
+                blit_convert_555(dst, (const uint8_t *) src, length);
+                break;
+            default:
+                break;
+        }
+        dst += length;
+        src += length;
+    }
+}
+
+static int run_implementation(blit_implementation implementation, int iterations)
+{
+    blit_set_implementation(implementation);
+    printf("%-7s", blit_implementation_name(implementation));
+    for (kernel k = 0; k < KERNEL_MAX; k++) {
+        memcpy(actual, background, sizeof(actual));
+        run_kernel(k, actual);
+        if (implementation == BLIT_SCALAR) {
+            memcpy(expected[k], actual, sizeof(actual));
+        } else if (memcmp(expected[k], actual, sizeof(actual)) != 0) {
+            printf("\n%s: %s draws different pixels than scalar\n",
+                blit_implementation_name(implementation), kernel_names[k]);
+            return 0;
+        }
+        uint64_t start = system_get_micros();
+        for (int i = 0; i < iterations; i++) {
+            run_kernel(k, actual);
+        }
+        uint64_t elapsed = system_get_micros() - start;
+        printf(" %13.1f", elapsed ? (double) NUM_PIXELS * iterations / elapsed : 0.0);
+    }
+    printf("\n");
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    if (iterations <= 0) {
+        printf("Usage: blitbench [iterations]\n");
+        return -1;
+    }
+    generate_pixels();
+    printf("Blitting %d pixels in %d rows, %d times per kernel, in Mpixels/s\n\n", NUM_PIXELS, num_rows, iterations);
+    printf("%-7s", "");
+    for (kernel k = 0; k < KERNEL_MAX; k++) {
+        printf(" %13s", kernel_names[k]);
+    }
+    printf("\n");
+
+    for (blit_implementation implementation = 0; implementation < BLIT_MAX_IMPLEMENTATIONS; implementation++) {
+        if (blit_is_supported(implementation) && !run_implementation(implementation, iterations)) {
+            return 1;
+        }
+    }
+    return 0;
+}
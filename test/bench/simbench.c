@@ -0,0 +1,136 @@
+#include "core/backtrace.h"
+#include "game/file.h"
+#include "game/game.h"
+#include "game/profiler.h"
+#include "game/system.h"
+#include "game/tick.h"
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void handler(int sig)
+{
+    fprintf(stderr, "Oops, crashed with signal %d :(", sig);
+    backtrace_print();
+    exit(1);
+}
+
+static int compare_durations(const void *a, const void *b)
+{
+    uint64_t va = *(const uint64_t *) a;
+    uint64_t vb = *(const uint64_t *) b;
+    return va < vb ? -1 : (va > vb ? 1 : 0);
+}
+
+static uint64_t percentile(const uint64_t *sorted, int count, int percent)
+{
+    return sorted[(count - 1) * percent / 100];
+}
+
+static void print_section(const profiler_section *s, uint64_t total_us)
+{
+    printf("%4s %7u %10.2f %8.1f %8llu %5.1f%%  %s\n", "", s->calls, s->total_us / 1000.0,
+        (double) s->total_us / s->calls, (unsigned long long) s->max_us,
+        total_us ? 100.0 * s->total_us / total_us : 0.0, s->name);
+}
+
+static void print_report(uint64_t *tick_durations, int ticks)
+{
+    uint64_t total_us = 0;
+    for (int i = 0; i < ticks; i++) {
+        total_us += tick_durations[i];
+    }
+    qsort(tick_durations, ticks, sizeof(uint64_t), compare_durations);
+
+    printf("Total: %.1f ms, %.1f ticks/s\n", total_us / 1000.0,
+        total_us ? ticks * 1000000.0 / total_us : 0.0);
+    printf("Tick time (us): p50 %llu, p90 %llu, p99 %llu, max %llu\n",
+        (unsigned long long) percentile(tick_durations, ticks, 50),
+        (unsigned long long) percentile(tick_durations, ticks, 90),
+        (unsigned long long) percentile(tick_durations, ticks, 99),
+        (unsigned long long) tick_durations[ticks - 1]);
+
+    printf("\n%4s %7s %10s %8s %8s %6s  %s\n", "Slot", "Calls", "Total ms", "Avg us", "Max us", "Share", "Section");
+    uint64_t slots_us = 0;
+    for (int slot = 0; slot < PROFILER_MAX_TICK_SLOTS; slot++) {
+        const profiler_section *s = game_profiler_get_tick_slot(slot);
+        if (!s->calls) {
+            continue;
+        }
+        slots_us += s->total_us;
+        printf("%4d %7u %10.2f %8llu %8llu %5.1f%%  %s\n", slot, s->calls, s->total_us / 1000.0,
+            (unsigned long long) (s->total_us / s->calls), (unsigned long long) s->max_us,
+            total_us ? 100.0 * s->total_us / total_us : 0.0, s->name);
+    }
+    uint64_t rest_us = total_us > slots_us ? total_us - slots_us : 0;
+    printf("%4s %7d %10.2f %8llu %8s %5.1f%%  %s\n", "-", ticks, rest_us / 1000.0,
+        (unsigned long long) (rest_us / ticks), "-",
+        total_us ? 100.0 * rest_us / total_us : 0.0, "rest of tick (figures, day/month changes, events)");
+
+    printf("\n%4s %7s %10s %8s %8s %6s  %s\n", "", "Calls", "Total ms", "Avg us", "Max us", "Share", "Call");
+    const profiler_section *s;
+    for (int i = 0; (s = game_profiler_get_call(i)) != 0; i++) {
+        print_section(s, total_us);
+    }
+    printf("\n%4s %7s %10s %8s %8s %6s  %s\n", "", "Actions", "Total ms", "Avg us", "Max us", "Share", "Figure");
+    for (int type = 0; type < PROFILER_MAX_FIGURE_TYPES; type++) {
+        s = game_profiler_get_figure_type(type);
+        if (s->calls) {
+            print_section(s, total_us);
+        }
+    }
+}
+
+static int run_benchmark(const char *saved_game, int ticks)
+{
+    printf("Benchmarking %s for %d ticks\n", saved_game, ticks);
+    signal(SIGSEGV, handler);
+
+    if (!game_pre_init()) {
+        printf("Unable to run Game_preInit\n");
+        return 1;
+    }
+    if (!game_init()) {
+        printf("Unable to run Game_init\n");
+        return 2;
+    }
+    if (!game_file_load_saved_game(saved_game)) {
+        printf("Unable to load saved game %s\n", saved_game);
+        return 3;
+    }
+    uint64_t *tick_durations = malloc(ticks * sizeof(uint64_t));
+    if (!tick_durations) {
+        printf("Unable to allocate memory for %d ticks\n", ticks);
+        return 4;
+    }
+
+    game_profiler_reset();
+    game_profiler_set_enabled(1);
+    for (int i = 0; i < ticks; i++) {
+        uint64_t start = system_get_micros();
+        game_tick_run();
+        tick_durations[i] = system_get_micros() - start;
+    }
+    game_profiler_set_enabled(0);
+
+    print_report(tick_durations, ticks);
+    free(tick_durations);
+    game_exit();
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        printf("Usage: simbench <saved game> <ticks>\n");
+        return -1;
+    }
+    int ticks = atoi(argv[2]);
+    if (ticks <= 0) {
+        printf("Number of ticks must be positive\n");
+        return -1;
+    }
+    return run_benchmark(argv[1], ticks);
+}
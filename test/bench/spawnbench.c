@@ -0,0 +1,175 @@
+#include "building/building.h"
+#include "core/backtrace.h"
+#include "figure/figure.h"
+#include "game/file.h"
+#include "game/game.h"
+#include "game/system.h"
+#include "game/undo.h"
+#include "map/grid.h"
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t random_state = 12345;
+static char spawned_building[MAX_BUILDINGS];
+
+static void handler(int sig)
+{
+    fprintf(stderr, "Oops, crashed with signal %d :(", sig);
+    backtrace_print();
+    exit(1);
+}
+
+static uint32_t next_random(void)
+{
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 8;
+}
+
+static int lowest_free_figure_id(void)
+{
+    for (int i = 1; i < MAX_FIGURES; i++) {
+        if (!figure_get(i)->state) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static int lowest_free_building_id(void)
+{
+    for (int i = 1; i < MAX_BUILDINGS; i++) {
+        if (building_get(i)->state == BUILDING_STATE_UNUSED && !game_undo_contains_building(i)) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static int spawn_walkers(int verify, int *spawned)
+{
+    int width, height;
+    map_grid_size(&width, &height);
+    while (1) {
+        int expected_id = verify ? lowest_free_figure_id() : 0;
+        figure *f = figure_create(FIGURE_PATRICIAN, next_random() % width, next_random() % height, DIR_0_TOP);
+        if (verify && f->id != expected_id) {
+            printf("Walker got id %d instead of the lowest free id %d\n", f->id, expected_id);
+            return 0;
+        }
+        if (!f->id) {
+            return 1;
+        }
+        (*spawned)++;
+    }
+}
+
+static void delete_walkers(void)
+{
+    for (int i = 1; i < MAX_FIGURES; i++) {
+        figure *f = figure_get(i);
+        if (f->state && f->type == FIGURE_PATRICIAN && next_random() % 2) {
+            figure_delete(f);
+        }
+    }
+}
+
+static int spawn_buildings(int verify, int *spawned)
+{
+    while (1) {
+        int expected_id = verify ? lowest_free_building_id() : 0;
+        building *b = building_create(BUILDING_GARDENS, 0, 0);
+        if (verify && b->id != expected_id) {
+            printf("Building got id %d instead of the lowest free id %d\n", b->id, expected_id);
+            return 0;
+        }
+        if (!b->id) {
+            return 1;
+        }
+        spawned_building[b->id] = 1;
+        (*spawned)++;
+    }
+}
+
+static void delete_buildings(void)
+{
+    for (int i = 1; i < MAX_BUILDINGS; i++) {
+        if (spawned_building[i] && next_random() % 2) {
+            building_get(i)->state = BUILDING_STATE_DELETED_BY_GAME;
+            spawned_building[i] = 0;
+        }
+    }
+    building_update_state();
+}
+
+static int run_rounds(int rounds, int verify)
+{
+    int walkers = 0;
+    int buildings = 0;
+    uint64_t walker_us = 0;
+    uint64_t building_us = 0;
+    for (int round = 0; round < rounds; round++) {
+        uint64_t start = system_get_micros();
+        if (!spawn_walkers(verify, &walkers)) {
+            return 0;
+        }
+        walker_us += system_get_micros() - start;
+        delete_walkers();
+
+        start = system_get_micros();
+        if (!spawn_buildings(verify, &buildings)) {
+            return 0;
+        }
+        building_us += system_get_micros() - start;
+        delete_buildings();
+    }
+    if (!verify) {
+        printf("Walkers:   %8d spawned in %8.2f ms, %6.3f us each\n", walkers, walker_us / 1000.0,
+            walkers ? (double) walker_us / walkers : 0.0);
+        printf("Buildings: %8d spawned in %8.2f ms, %6.3f us each\n", buildings, building_us / 1000.0,
+            buildings ? (double) building_us / buildings : 0.0);
+    }
+    return 1;
+}
+
+static int run_benchmark(const char *saved_game, int rounds)
+{
+    printf("Spawning walkers and buildings in %s until full, %d rounds\n", saved_game, rounds);
+    signal(SIGSEGV, handler);
+
+    if (!game_pre_init()) {
+        printf("Unable to run Game_preInit\n");
+        return 1;
+    }
+    if (!game_init()) {
+        printf("Unable to run Game_init\n");
+        return 2;
+    }
+    if (!game_file_load_saved_game(saved_game)) {
+        printf("Unable to load saved game %s\n", saved_game);
+        return 3;
+    }
+    // every slot that gets picked must be the lowest free one, as the saved games depend on it
+    if (!run_rounds(2, 1)) {
+        return 4;
+    }
+    run_rounds(rounds, 0);
+    game_exit();
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        printf("Usage: spawnbench <saved game> <rounds>\n");
+        return -1;
+    }
+    int rounds = atoi(argv[2]);
+    if (rounds <= 0) {
+        printf("Number of rounds must be positive\n");
+        return -1;
+    }
+    return run_benchmark(argv[1], rounds);
+}
@@ -0,0 +1,117 @@
+#include "core/zip.h"
+#include "game/system.h"
+#include "sav/sav_compare.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PIECE_SIZE 1300000
+
+typedef struct {
+    unsigned char *data;
+    int length;
+} corpus_piece;
+
+static struct {
+    corpus_piece *pieces;
+    int num_pieces;
+    int capacity;
+    int64_t total_bytes;
+} corpus;
+
+static unsigned char compressed[MAX_PIECE_SIZE];
+static unsigned char decompressed[MAX_PIECE_SIZE];
+
+static const char *level_names[] = {"", "fastest", "fast", "high", "original"};
+
+static void add_piece(const char *name, const unsigned char *data, int length, void *userdata)
+{
+    if (corpus.num_pieces >= corpus.capacity) {
+        int capacity = corpus.capacity ? corpus.capacity * 2 : 256;
+        corpus_piece *pieces = realloc(corpus.pieces, capacity * sizeof(corpus_piece));
+        if (!pieces) {
+            return;
+        }
+        corpus.pieces = pieces;
+        corpus.capacity = capacity;
+    }
+    unsigned char *copy = malloc(length);
+    if (!copy) {
+        return;
+    }
+    memcpy(copy, data, length);
+    corpus.pieces[corpus.num_pieces].data = copy;
+    corpus.pieces[corpus.num_pieces].length = length;
+    corpus.num_pieces++;
+    corpus.total_bytes += length;
+}
+
+static void free_corpus(void)
+{
+    for (int i = 0; i < corpus.num_pieces; i++) {
+        free(corpus.pieces[i].data);
+    }
+    free(corpus.pieces);
+}
+
+static int run_level(zip_level level)
+{
+    int64_t compressed_bytes = 0;
+    uint64_t compress_us = 0;
+    uint64_t decompress_us = 0;
+    for (int i = 0; i < corpus.num_pieces; i++) {
+        const corpus_piece *piece = &corpus.pieces[i];
+        int compressed_length = MAX_PIECE_SIZE;
+        uint64_t start = system_get_micros();
+        if (!zip_compress_level(piece->data, piece->length, compressed, &compressed_length, level)) {
+            printf("Compressing piece %d failed at level %s\n", i, level_names[level]);
+            return 0;
+        }
+        uint64_t middle = system_get_micros();
+        int decompressed_length = MAX_PIECE_SIZE;
+        if (!zip_decompress(compressed, compressed_length, decompressed, &decompressed_length)) {
+            printf("Decompressing piece %d failed at level %s\n", i, level_names[level]);
+            return 0;
+        }
+        uint64_t end = system_get_micros();
+        if (decompressed_length != piece->length || memcmp(decompressed, piece->data, piece->length) != 0) {
+            printf("Piece %d does not survive a round trip at level %s\n", i, level_names[level]);
+            return 0;
+        }
+        compressed_bytes += compressed_length;
+        compress_us += middle - start;
+        decompress_us += end - middle;
+    }
+    printf("%-9s %12lld %7.2f%% %14.1f %16.1f\n", level_names[level], (long long) compressed_bytes,
+        100.0 * compressed_bytes / corpus.total_bytes,
+        compress_us ? corpus.total_bytes / (double) compress_us : 0.0,
+        decompress_us ? corpus.total_bytes / (double) decompress_us : 0.0);
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        printf("Usage: zipbench <saved game>...\n");
+        return -1;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (!for_each_compressed_part(argv[i], add_piece, 0)) {
+            printf("Unable to read saved game %s\n", argv[i]);
+            free_corpus();
+            return 1;
+        }
+    }
+    printf("Compressing %d pieces from %d saved games, %lld bytes in total\n\n",
+        corpus.num_pieces, argc - 1, (long long) corpus.total_bytes);
+    printf("%-9s %12s %8s %14s %16s\n", "Level", "Compressed", "Ratio", "Compress MB/s", "Decompress MB/s");
+
+    int ok = 1;
+    for (zip_level level = ZIP_LEVEL_FASTEST; level <= ZIP_LEVEL_ORIGINAL && ok; level++) {
+        ok = run_level(level);
+    }
+    free_corpus();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+#include "city/view.h"
+#include "core/backtrace.h"
+#include "core/time.h"
+#include "game/file.h"
+#include "game/game.h"
+#include "game/orientation.h"
+#include "game/settings.h"
+#include "graphics/color.h"
+#include "graphics/graphics.h"
+#include "graphics/screen.h"
+#include "map/grid.h"
+#include "map/image.h"
+#include "map/point.h"
+#include "map/property.h"
+#include "stub/image_stub.h"
+#include "widget/city_without_overlay.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Tall enough for the most bands the city is drawn in
+#define SCREEN_WIDTH 1600
+#define SCREEN_HEIGHT 2000
+#define CAMERA_STEPS 3
+#define CACHE_FRAMES 40
+#define TICKS_BETWEEN_FRAMES 10
+
+typedef void (*city_draw_func)(int selected_figure_id, pixel_coordinate *figure_coord, const map_tile *tile);
+
+// The same drawing code, built with a single band and without the ground cache
+void city_without_overlay_draw_one_band(int selected_figure_id, pixel_coordinate *figure_coord, const map_tile *tile);
+void city_without_overlay_draw_no_ground_cache(
+    int selected_figure_id, pixel_coordinate *figure_coord, const map_tile *tile);
+
+// Camera moves between frames, in pixels: small and large scrolls, both odd and even rows
+static const int SCROLLS[][2] = {
+    {0, 0}, {30, 15}, {-45, 7}, {0, -90}, {121, 0}, {1, 1}, {-300, 200}, {0, 0}, {60, -31}, {2000, 0}
+};
+
+static color_t expected[SCREEN_WIDTH * SCREEN_HEIGHT];
+static color_t actual[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+static void handler(int sig)
+{
+    fprintf(stderr, "Oops, crashed with signal %d :(", sig);
+    backtrace_print();
+    exit(1);
+}
+
+static void set_footprint_sizes(void)
+{
+    for (int grid_offset = 0; grid_offset < GRID_SIZE * GRID_SIZE; grid_offset++) {
+        if (map_property_is_draw_tile(grid_offset)) {
+            image_stub_set_footprint(map_image_at(grid_offset), map_property_multi_tile_size(grid_offset));
+        }
+    }
+}
+
+static int draw_city(city_draw_func draw, color_t *pixels)
+{
+    int x, y, width, height;
+    city_view_get_viewport(&x, &y, &width, &height);
+    graphics_clear_screen();
+    graphics_set_clip_rectangle(x, y, width, height);
+    map_tile tile = {0};
+    draw(0, 0, &tile);
+    graphics_reset_clip_rectangle();
+    graphics_save_to_buffer(x, y, width, height, pixels);
+    int drawn = 0;
+    for (int i = 0; i < width * height; i++) {
+        if (pixels[i] != COLOR_BLACK) {
+            drawn++;
+        }
+    }
+    return drawn;
+}
+
+// The water moves when a draw function is called 60 ms after it last moved the water. The expected draw is
+// done at the given time and may move the water. The actual draw is always done at time 0, so it never
+// moves the water itself and has to draw the water the way the expected draw left it.
+static int compare_draws(const char *description, city_draw_func draw_expected, city_draw_func draw_actual,
+    time_millis expected_time)
+{
+    int x, y, width, height;
+    city_view_get_viewport(&x, &y, &width, &height);
+    set_footprint_sizes();
+    time_set_millis(expected_time);
+    int drawn = draw_city(draw_expected, expected);
+    time_set_millis(0);
+    if (!drawn) {
+        printf("%s: nothing was drawn\n", description);
+        return 0;
+    }
+    draw_city(draw_actual, actual);
+    int differences = 0;
+    int first = -1;
+    for (int i = 0; i < width * height; i++) {
+        if (expected[i] != actual[i]) {
+            if (first < 0) {
+                first = i;
+            }
+            differences++;
+        }
+    }
+    if (differences) {
+        printf("%s: %d pixels differ, the first at (%d, %d)\n", description, differences,
+            first % width + x, first / width + y);
+        return 0;
+    }
+    return 1;
+}
+
+static int load_saved_game(const char *saved_game)
+{
+    if (!game_file_load_saved_game(saved_game)) {
+        printf("Unable to load saved game %s\n", saved_game);
+        return 0;
+    }
+    screen_set_resolution(SCREEN_WIDTH, SCREEN_HEIGHT);
+    return 1;
+}
+
+static void run_ticks(int ticks)
+{
+    setting_reset_speeds(500, setting_scroll_speed());
+    for (int i = 1; i <= ticks; i++) {
+        time_set_millis(2 * i);
+        game_run();
+    }
+    time_set_millis(0);
+}
+
+static int check_bands(const char *saved_game)
+{
+    if (!load_saved_game(saved_game)) {
+        return 0;
+    }
+    int map_width, map_height;
+    map_grid_size(&map_width, &map_height);
+    int ok = 1;
+    for (int orientation = 0; orientation < 4; orientation++) {
+        for (int i = 0; i < CAMERA_STEPS; i++) {
+            for (int j = 0; j < CAMERA_STEPS; j++) {
+                int x = map_width * (2 * i + 1) / (2 * CAMERA_STEPS);
+                int y = map_height * (2 * j + 1) / (2 * CAMERA_STEPS);
+                city_view_go_to_grid_offset(map_grid_offset(x, y));
+                char description[200];
+                snprintf(description, sizeof(description), "%s, orientation %d, camera at tile (%d, %d)",
+                    saved_game, city_view_orientation(), x, y);
+                if (!compare_draws(description, city_without_overlay_draw_one_band, city_without_overlay_draw, 0)) {
+                    ok = 0;
+                }
+            }
+        }
+        game_orientation_rotate_right();
+    }
+    return ok;
+}
+
+static int check_ground_cache(const char *saved_game)
+{
+    // the ground cache is kept from the previous saved game, which may have another map size
+    if (!load_saved_game(saved_game)) {
+        return 0;
+    }
+    int map_width, map_height;
+    map_grid_size(&map_width, &map_height);
+    city_view_go_to_grid_offset(map_grid_offset(map_width / 2, map_height / 2));
+    int ok = 1;
+    int num_scrolls = sizeof(SCROLLS) / sizeof(SCROLLS[0]);
+    for (int frame = 0; frame < CACHE_FRAMES; frame++) {
+        const int *scroll = SCROLLS[frame % num_scrolls];
+        city_view_scroll(scroll[0], scroll[1]);
+        if (frame % 3 == 2) {
+            run_ticks(TICKS_BETWEEN_FRAMES);
+        }
+        if (frame == CACHE_FRAMES / 2) {
+            game_orientation_rotate_left();
+        }
+        int camera_x, camera_y;
+        city_view_get_camera(&camera_x, &camera_y);
+        char description[200];
+        snprintf(description, sizeof(description), "%s (map %dx%d), frame %d, camera at view tile (%d, %d)",
+            saved_game, map_width, map_height, frame, camera_x, camera_y);
+        if (!compare_draws(description, city_without_overlay_draw_no_ground_cache, city_without_overlay_draw,
+                100 * (frame + 1))) {
+            ok = 0;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3 || (strcmp(argv[1], "bands") != 0 && strcmp(argv[1], "cache") != 0)) {
+        printf("Usage: drawcheck bands|cache <saved game>...\n");
+        return -1;
+    }
+    int check_cache = strcmp(argv[1], "cache") == 0;
+    signal(SIGSEGV, handler);
+    if (!game_pre_init()) {
+        printf("Unable to run Game_preInit\n");
+        return 1;
+    }
+    if (!game_init()) {
+        printf("Unable to run Game_init\n");
+        return 2;
+    }
+    int ok = 1;
+    for (int i = 2; i < argc; i++) {
+        if (check_cache) {
+            printf("Drawing %s with and without the ground cache\n", argv[i]);
+            ok = check_ground_cache(argv[i]) && ok;
+        } else {
+            printf("Drawing %s in one band and in parallel bands\n", argv[i]);
+            ok = check_bands(argv[i]) && ok;
+        }
+    }
+    game_exit();
+    return ok ? 0 : 3;
+}
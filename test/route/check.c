@@ -0,0 +1,68 @@
+#include "core/buffer.h"
+#include "core/direction.h"
+#include "figure/route.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_PATH_LENGTH 500
+#define MAX_SAVED_ROUTES 600
+
+static uint8_t figure_data[MAX_SAVED_ROUTES * 2];
+static uint8_t path_data[MAX_SAVED_ROUTES * MAX_PATH_LENGTH];
+static uint8_t saved_figure_data[MAX_SAVED_ROUTES * 2];
+static uint8_t saved_path_data[MAX_SAVED_ROUTES * MAX_PATH_LENGTH];
+
+static int failures;
+
+static void set_route(int path_id, int figure_id, const uint8_t *path, int length)
+{
+    figure_data[path_id * 2] = figure_id & 0xff;
+    figure_data[path_id * 2 + 1] = figure_id >> 8;
+    memcpy(&path_data[path_id * MAX_PATH_LENGTH], path, length);
+}
+
+static void check_path(const char *name, int path_id)
+{
+    for (int i = 0; i < MAX_PATH_LENGTH; i++) {
+        int expected = path_data[path_id * MAX_PATH_LENGTH + i];
+        int actual = figure_route_get_direction(path_id, i);
+        if (actual != expected) {
+            printf("%s: direction %d is %d instead of %d\n", name, i, actual, expected);
+            failures++;
+            return;
+        }
+    }
+}
+
+int main(void)
+{
+    static const uint8_t ends_north[] = {DIR_2_RIGHT, DIR_2_RIGHT, DIR_4_BOTTOM, DIR_0_TOP, DIR_0_TOP, DIR_0_TOP};
+    static const uint8_t only_north[] = {DIR_0_TOP, DIR_0_TOP, DIR_0_TOP, DIR_0_TOP};
+    static const uint8_t unused[] = {DIR_6_LEFT, DIR_6_LEFT, DIR_0_TOP};
+    set_route(1, 10, ends_north, sizeof(ends_north));
+    set_route(2, 11, only_north, sizeof(only_north));
+    set_route(3, 0, unused, sizeof(unused));
+
+    buffer figures, paths;
+    buffer_init(&figures, figure_data, sizeof(figure_data));
+    buffer_init(&paths, path_data, sizeof(path_data));
+    figure_route_load_state(&figures, &paths);
+
+    check_path("Path ending north", 1);
+    check_path("Path going only north", 2);
+    check_path("Unused path", 3);
+    check_path("Empty path", 4);
+
+    buffer_init(&figures, saved_figure_data, sizeof(saved_figure_data));
+    buffer_init(&paths, saved_path_data, sizeof(saved_path_data));
+    figure_route_save_state(&figures, &paths);
+    if (memcmp(figure_data, saved_figure_data, sizeof(figure_data)) != 0 ||
+        memcmp(path_data, saved_path_data, sizeof(path_data)) != 0) {
+        printf("Saved routes differ from the loaded ones\n");
+        failures++;
+    }
+    figure_route_clear_all();
+    return failures ? 1 : 0;
+}
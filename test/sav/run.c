@@ -3,6 +3,7 @@
 #include "game/file.h"
 #include "game/game.h"
 #include "game/settings.h"
+#include "map/desirability.h"
 
 #ifdef _MSC_VER
 #include <direct.h>
@@ -58,7 +59,13 @@ static int run_autopilot(const char *input_saved_game, const char *output_saved_
         }
         return 3;
     }
+    map_desirability_set_verify(1);
     run_ticks(ticks_to_run);
+    if (map_desirability_verify_failures()) {
+        printf("Incremental desirability differed from the full update %d times\n",
+            map_desirability_verify_failures());
+        return 4;
+    }
     printf("Saving game to %s\n", output_saved_game);
     game_file_write_saved_game(output_saved_game);
     printf("Done\n");
@@ -588,3 +588,18 @@ int compare_files(const char *file1, const char *file2)
         return 1;
     }
 }
+
+int for_each_compressed_part(const char *file, sav_part_callback callback, void *userdata)
+{
+    if (!unpack(file, file1_data)) {
+        return 0;
+    }
+    int offset = 0;
+    for (int i = 0; save_game_parts[i].length_in_bytes; i++) {
+        if (save_game_parts[i].compressed) {
+            callback(save_game_parts[i].name, &file1_data[offset], save_game_parts[i].length_in_bytes, userdata);
+        }
+        offset += save_game_parts[i].length_in_bytes;
+    }
+    return 1;
+}
@@ -3,4 +3,8 @@
 
 int compare_files(const char *file1, const char *file2);
 
+typedef void (*sav_part_callback)(const char *name, const unsigned char *data, int length, void *userdata);
+
+int for_each_compressed_part(const char *file, sav_part_callback callback, void *userdata);
+
 #endif // SAV_COMPARE_H
@@ -1,4 +1,29 @@
 #include "core/image.h"
+#include "stub/image_stub.h"
+
+#include <stdlib.h>
+
+// Images are made up when they are first asked for, so drawing code can run without the game files
+#define MAX_STUB_IMAGES 12000
+#define MAX_STUB_LETTERS 512
+#define SPRITE_WIDTH 40
+#define SPRITE_HEIGHT 50
+#define LETTER_WIDTH 8
+#define LETTER_HEIGHT 12
+#define MIN_TOP_HEIGHT 60
+#define MAX_TOP_HEIGHT 240
+
+typedef struct {
+    image img;
+    color_t *data;
+} stub_image;
+
+static struct {
+    stub_image images[MAX_STUB_IMAGES];
+    stub_image enemy_images[MAX_STUB_IMAGES];
+    stub_image letters[MAX_STUB_LETTERS];
+    int footprint_sizes[MAX_STUB_IMAGES];
+} stubs;
 
 static int groups[] = {
     0, 245, 254, 246, 274, 364, 444, 476, 534, 201,
@@ -58,7 +83,132 @@ int image_group(int group)
     return groups[group];
 }
 
+static color_t stub_color(int id, int part)
+{
+    uint32_t hash = (uint32_t) id * 2654435761u ^ (uint32_t) (part + 1) * 40503u;
+    return ALPHA_OPAQUE | (hash & 0xffffff);
+}
+
+static void create_sprite(stub_image *stub, int id, int width, int height, int is_compressed)
+{
+    stub->img.width = width;
+    stub->img.height = height;
+    stub->img.sprite_offset_x = width / 2;
+    stub->img.sprite_offset_y = height - 10;
+    stub->img.draw.type = IMAGE_TYPE_WITH_TRANSPARENCY;
+    stub->img.draw.is_fully_compressed = is_compressed;
+    stub->data = malloc(sizeof(color_t) * (width + 4) * height);
+    color_t *pixel = stub->data;
+    for (int y = 0; y < height; y++) {
+        // leave the corners transparent, like most sprites
+        int corner = y < 4 || y >= height - 4 ? 4 : 0;
+        if (is_compressed) {
+            if (corner) {
+                *pixel++ = 255;
+                *pixel++ = corner;
+            }
+            *pixel++ = width - 2 * corner;
+        }
+        for (int x = 0; x < width; x++) {
+            int is_corner = x < corner || x >= width - corner;
+            if (!is_corner) {
+                *pixel++ = stub_color(id, y / 4);
+            } else if (!is_compressed) {
+                *pixel++ = COLOR_SG2_TRANSPARENT;
+            }
+        }
+        if (is_compressed && corner) {
+            *pixel++ = 255;
+            *pixel++ = corner;
+        }
+    }
+}
+
+static void create_isometric(stub_image *stub, int id, int size)
+{
+    int footprint_pixels = 900 * size * size;
+    stub->img.width = 60 * size - 2;
+    // tops of different heights, so they reach into different bands
+    stub->img.height = 30 * size + MIN_TOP_HEIGHT + id * 37 % (MAX_TOP_HEIGHT - MIN_TOP_HEIGHT);
+    // the drawing code leaves out the rows that lie below the middle of the footprint
+    int top_rows = stub->img.height - 15 * size - 1;
+    stub->img.draw.type = IMAGE_TYPE_ISOMETRIC;
+    stub->img.draw.has_compressed_part = 1;
+    stub->img.draw.uncompressed_length = footprint_pixels;
+    stub->data = malloc(sizeof(color_t) * (footprint_pixels + top_rows * (stub->img.width + 1)));
+    for (int i = 0; i < footprint_pixels; i++) {
+        stub->data[i] = stub_color(id, i / 15);
+    }
+    // the top is a narrower block: every row is a transparent skip, a run of pixels and another skip
+    color_t *top = &stub->data[footprint_pixels];
+    int margin = 10 * size;
+    int run = stub->img.width - 2 * margin;
+    for (int y = 0; y < top_rows; y++) {
+        *top++ = 255;
+        *top++ = margin;
+        *top++ = run;
+        for (int x = 0; x < run; x++) {
+            *top++ = stub_color(id, 1000 + y / 3);
+        }
+        *top++ = 255;
+        *top++ = margin;
+    }
+}
+
+void image_stub_set_footprint(int id, int size)
+{
+    if (id > 0 && id < MAX_STUB_IMAGES && size >= 1 && size <= 5 && !stubs.images[id].data) {
+        stubs.footprint_sizes[id] = size;
+    }
+}
+
+static const stub_image *get_stub(stub_image *images, int max_images, int id)
+{
+    if (id < 0 || id >= max_images) {
+        id = 0;
+    }
+    stub_image *stub = &images[id];
+    if (!stub->data) {
+        if (images == stubs.letters) {
+            create_sprite(stub, id, LETTER_WIDTH, LETTER_HEIGHT, 1);
+        } else if (images == stubs.enemy_images) {
+            // enemy images are always compressed
+            create_sprite(stub, id, SPRITE_WIDTH, SPRITE_HEIGHT, 1);
+        } else if (stubs.footprint_sizes[id]) {
+            create_isometric(stub, id, stubs.footprint_sizes[id]);
+        } else {
+            create_sprite(stub, id, SPRITE_WIDTH, SPRITE_HEIGHT, 0);
+        }
+    }
+    return stub;
+}
+
 const image *image_get(int id)
 {
-    return 0;
+    return &get_stub(stubs.images, MAX_STUB_IMAGES, id)->img;
+}
+
+const image *image_letter(int letter_id)
+{
+    return &get_stub(stubs.letters, MAX_STUB_LETTERS, letter_id)->img;
+}
+
+const image *image_get_enemy(int id)
+{
+    return &get_stub(stubs.enemy_images, MAX_STUB_IMAGES, id)->img;
+}
+
+const color_t *image_data(int id)
+{
+    return get_stub(stubs.images, MAX_STUB_IMAGES, id)->data;
+}
+
+const color_t *image_data_letter(int letter_id)
+{
+    return get_stub(stubs.letters, MAX_STUB_LETTERS, letter_id)->data;
+}
+
+const color_t *image_data_enemy(int id)
+{
+    return get_stub(stubs.enemy_images, MAX_STUB_IMAGES, id)->data;
 }
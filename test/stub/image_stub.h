@@ -0,0 +1,12 @@
+#ifndef TEST_STUB_IMAGE_STUB_H
+#define TEST_STUB_IMAGE_STUB_H
+
+/**
+ * Makes the image an isometric image with a footprint of the given size.
+ * Only the map knows the footprint sizes, so this has to be called before the image is first used.
+ * @param id Image ID
+ * @param size Footprint size in tiles
+ */
+void image_stub_set_footprint(int id, int size);
+
+#endif // TEST_STUB_IMAGE_STUB_H
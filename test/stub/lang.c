@@ -1,6 +1,5 @@
 #include "core/encoding.h"
 #include "core/lang.h"
-#include "graphics/font.h"
 #include "translation/translation.h"
 
 static uint8_t EMPTY[] = {0};
@@ -23,8 +22,5 @@ const lang_message *lang_get_message(int id)
     return &msg;
 }
 
-void font_set_encoding(encoding_type encoding)
-{}
-
 void translation_load(language_type language)
 {}
@@ -0,0 +1,54 @@
+#include "game/system.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t system_get_micros(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000 +
+        (uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+void system_run_parallel(system_task_func task, void *data, int count)
+{
+    for (int i = 0; i < count; i++) {
+        task(data, i);
+    }
+}
+
+void system_run_in_background(void (*task)(void *data), void *data)
+{
+    task(data);
+}
+
+int system_background_task_running(void)
+{
+    return 0;
+}
+
+void system_wait_for_background_task(void)
+{
+}
+
+color_t *system_create_framebuffer(int width, int height)
+{
+    static color_t *framebuffer;
+    free(framebuffer);
+    framebuffer = malloc((size_t) width * height * sizeof(color_t));
+    return framebuffer;
+}